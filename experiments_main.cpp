@@ -7,6 +7,7 @@
 #include "sketch/hash_weighted.hpp"
 #include "sketch/tensor.hpp"
 #include "sketch/tensor_block.hpp"
+#include "sketch/tensor_multi.hpp"
 #include "sketch/tensor_slide.hpp"
 #include "sketch/tensor_slide_flat.hpp"
 #include "util/multivec.hpp"
@@ -106,17 +107,16 @@ DEFINE_validator(transform, &ValidateTransformation);
 
 
 static bool ValidateHashAlg(const char *flagname, const std::string &value) {
-    if (value == "uniform" || value == "crc32" || value == "murmur") {
+    if (value == "uniform" || value == "crc32" || value == "murmur" || value == "mix32") {
         return true;
     }
     printf("Invalid value for --%s: %s\n", flagname, value.c_str());
     return false;
 }
 // Use CRC32 only for comparing speed
-// TODO: implement a proper iterative permutation generation for hash*
 DEFINE_string(hash_alg,
               "murmur",
-              "hash algorithm to be used as basis, can be 'murmur', 'uniform', or 'crc32'");
+              "hash algorithm to be used as basis, can be 'murmur', 'uniform', 'crc32', or 'mix32'");
 DEFINE_validator(hash_alg, &ValidateHashAlg);
 
 DEFINE_uint32(num_bins, 256, "Number of bins used to discretize, if --transform=disc");
@@ -126,6 +126,11 @@ DEFINE_uint32(num_threads, 0, "number of OpenMP threads, default: use all availa
 
 DEFINE_uint32(reruns, 1, "The number of times to rerun sketch algorithms on the same data");
 
+DEFINE_uint32(ts_repetitions,
+              5,
+              "The number of independent sketches computed in a single pass by TS_multi, whose "
+              "distances are reduced with the median");
+
 // individual flags, use global values if 0 (default)
 
 DEFINE_uint32(mh_kmer_size, 0, "Kmer size for MH, default: kmer_size");
@@ -435,34 +440,40 @@ int main(int argc, char *argv[]) {
         return random_device();
     };
 
-    auto experiment = MakeExperimentRunner<char_type, kmer_type>(
-            MinHash<kmer_type>(int_pow<uint32_t>(FLAGS_alphabet_size, FLAGS_mh_kmer_size),
-                               FLAGS_mh_dim, parse_hash_algorithm(FLAGS_hash_alg), rd(), "MH",
-                               FLAGS_mh_kmer_size),
-            WeightedMinHash<kmer_type>(int_pow<uint32_t>(FLAGS_alphabet_size, FLAGS_wmh_kmer_size),
-                                       FLAGS_wmh_dim, FLAGS_max_len,
-                                       parse_hash_algorithm(FLAGS_hash_alg), rd(), "WMH",
-                                       FLAGS_wmh_kmer_size),
-            OrderedMinHash<kmer_type>(int_pow<uint32_t>(FLAGS_alphabet_size, FLAGS_omh_kmer_size),
-                                      FLAGS_omh_dim, FLAGS_max_len, FLAGS_omh_tuple_length,
-                                      parse_hash_algorithm(FLAGS_hash_alg), rd(), "OMH",
-                                      FLAGS_omh_kmer_size),
-            Tensor<char_type>(FLAGS_alphabet_size, FLAGS_ts_dim, FLAGS_ts_tuple_length, rd(), "TS"),
-            TensorBlock<char_type>(FLAGS_alphabet_size, FLAGS_ts_dim, FLAGS_ts_tuple_length,
-                                   FLAGS_block_size, rd(), "TSB"),
-            TensorSlide<char_type>(FLAGS_alphabet_size, FLAGS_tss_dim, FLAGS_tss_tuple_length,
-                                   FLAGS_tss_window_size, FLAGS_tss_stride, rd(), "TSS"),
-            TensorSlideFlat<char_type, Int32Flattener>(
-                    FLAGS_alphabet_size, FLAGS_tss_dim, FLAGS_tss_tuple_length,
-                    FLAGS_tss_window_size, FLAGS_tss_stride,
-                    Int32Flattener(FLAGS_embed_dim, FLAGS_tss_dim, FLAGS_seq_len, rd()), rd(),
-                    "TSS_flat_int32"),
-            TensorSlideFlat<char_type, DoubleFlattener>(
-                    FLAGS_alphabet_size, FLAGS_tss_dim, FLAGS_tss_tuple_length,
-                    FLAGS_tss_window_size, FLAGS_tss_stride,
-                    DoubleFlattener(FLAGS_embed_dim, FLAGS_tss_dim, FLAGS_seq_len, rd()), rd(),
-                    "TSS_flat_double"));
-    experiment.run();
+    // the min-hash sketches are instantiated for the hash algorithm given by --hash_alg
+    run_function_on_hash_algorithm(parse_hash_algorithm(FLAGS_hash_alg), [&](auto hash) {
+        constexpr HashAlgorithm kHash = decltype(hash)::value;
+        auto experiment = MakeExperimentRunner<char_type, kmer_type>(
+                MinHash<kmer_type, kHash>(
+                        int_pow<uint32_t>(FLAGS_alphabet_size, FLAGS_mh_kmer_size), FLAGS_mh_dim,
+                        rd(), "MH", FLAGS_mh_kmer_size),
+                WeightedMinHash<kmer_type, kHash>(
+                        int_pow<uint32_t>(FLAGS_alphabet_size, FLAGS_wmh_kmer_size), FLAGS_wmh_dim,
+                        FLAGS_max_len, rd(), "WMH", FLAGS_wmh_kmer_size),
+                OrderedMinHash<kmer_type, kHash>(
+                        int_pow<uint32_t>(FLAGS_alphabet_size, FLAGS_omh_kmer_size), FLAGS_omh_dim,
+                        FLAGS_max_len, FLAGS_omh_tuple_length, rd(), "OMH", FLAGS_omh_kmer_size),
+                Tensor<char_type>(FLAGS_alphabet_size, FLAGS_ts_dim, FLAGS_ts_tuple_length, rd(),
+                                  "TS"),
+                TensorMulti<char_type>(FLAGS_alphabet_size, FLAGS_ts_dim, FLAGS_ts_tuple_length,
+                                       FLAGS_ts_repetitions, rd(),
+                                       TensorMulti<char_type>::Reducer::median, "TS_multi"),
+                TensorBlock<char_type>(FLAGS_alphabet_size, FLAGS_ts_dim, FLAGS_ts_tuple_length,
+                                       FLAGS_block_size, rd(), "TSB"),
+                TensorSlide<char_type>(FLAGS_alphabet_size, FLAGS_tss_dim, FLAGS_tss_tuple_length,
+                                       FLAGS_tss_window_size, FLAGS_tss_stride, rd(), "TSS"),
+                TensorSlideFlat<char_type, Int32Flattener>(
+                        FLAGS_alphabet_size, FLAGS_tss_dim, FLAGS_tss_tuple_length,
+                        FLAGS_tss_window_size, FLAGS_tss_stride,
+                        Int32Flattener(FLAGS_embed_dim, FLAGS_tss_dim, FLAGS_seq_len, rd()), rd(),
+                        "TSS_flat_int32"),
+                TensorSlideFlat<char_type, DoubleFlattener>(
+                        FLAGS_alphabet_size, FLAGS_tss_dim, FLAGS_tss_tuple_length,
+                        FLAGS_tss_window_size, FLAGS_tss_stride,
+                        DoubleFlattener(FLAGS_embed_dim, FLAGS_tss_dim, FLAGS_seq_len, rd()), rd(),
+                        "TSS_flat_double"));
+        experiment.run();
+    });
 
     return 0;
 }
@@ -27,17 +27,40 @@ class Int32Flattener {
 
     std::vector<uint32_t> flatten(const Vec2D<double> &sketch) {
         Timer timer("Int32Flattener");
-        assert(rand_proj.size() == flat_dim);
-        std::vector<uint32_t> v(flat_dim, 0);
+        std::vector<double> acc = accumulator();
+        for (size_t i = 0; i < sketch.size(); i++) {
+            add(i, sketch[i], &acc);
+        }
+        return finish(acc, sketch.size());
+    }
+
+    /** Returns the zero accumulator to which #add adds the projections of the sketches */
+    std::vector<double> accumulator() const { return std::vector<double>(flat_dim * 32, 0); }
+
+    /**
+     * Adds the projection of the i-th sketch to #acc. Adding the sketches one by one as they are
+     * computed and calling #finish gives the same result as #flatten.
+     */
+    void add(size_t i, const std::vector<double> &sketch, std::vector<double> *acc) const {
+        assert(sketch.size() == sketch_dim && acc->size() == flat_dim * 32);
         for (uint32_t s1 = 0; s1 < flat_dim; s1++) {
+            size_t j = s1 % sketch_dim;
+            const uint32_t bits = rand_proj[s1][i * sketch_dim + j];
+            double *val = acc->data() + s1 * 32;
             for (uint32_t s2 = 0; s2 < 32; s2++) { // iterate over 32 bits
-                size_t j = s1 % sketch_dim;
-                double val = 0;
-                for (size_t i = 0; i < sketch.size(); i++) {
-                    auto bit = rand_proj[s1][i * sketch_dim + j] >> s2; // random bit
-                    val += (bit & 1) ? sketch[i][j] : -sketch[i][j];
-                }
-                v[s1] = (v[s1] << 1) + std::signbit(val); // insert sgn(val) into v[s1]
+                // add sketch[j] if the random bit is set, and -sketch[j] otherwise
+                val[s2] += (2 * (int32_t)((bits >> s2) & 1) - 1) * sketch[j];
+            }
+        }
+    }
+
+    /** Returns the flattened sketch from the accumulated projections */
+    std::vector<uint32_t> finish(const std::vector<double> &acc, size_t /*num_sketches*/) const {
+        std::vector<uint32_t> v(flat_dim, 0);
+        for (uint32_t s1 = 0; s1 < flat_dim; s1++) {
+            for (uint32_t s2 = 0; s2 < 32; s2++) {
+                // insert the sign of the projection into v[s1]
+                v[s1] = (v[s1] << 1) + std::signbit(acc[s1 * 32 + s2]);
             }
         }
         return v;
@@ -83,19 +106,37 @@ class DoubleFlattener {
 
     std::vector<double> flatten(const Vec2D<double> &sketch) {
         Timer timer("DoubleFlattener");
-        assert(rand_proj.size() == flat_dim);
-        std::vector<double> v(this->flat_dim, 0);
+        std::vector<double> acc = accumulator();
+        for (size_t i = 0; i < sketch.size(); i++) {
+            add(i, sketch[i], &acc);
+        }
+        return finish(acc, sketch.size());
+    }
+
+    /** Returns the zero accumulator to which #add adds the projections of the sketches */
+    std::vector<double> accumulator() const { return std::vector<double>(flat_dim, 0); }
+
+    /**
+     * Adds the projection of the i-th sketch to #acc. Adding the sketches one by one as they are
+     * computed and calling #finish gives the same result as #flatten.
+     */
+    void add(size_t i, const std::vector<double> &sketch, std::vector<double> *acc) const {
+        assert(sketch.size() == sketch_dim && acc->size() == flat_dim);
         for (size_t s = 0; s < this->flat_dim; s++) {
             size_t j = s % this->sketch_dim;
-            for (size_t i = 0; i < sketch.size(); i++) {
-                v[s] += rand_proj[s][i * this->sketch_dim + j] * sketch[i][j];
-            }
-            v[s] /= (double)(sketch.size()
-                             * sketch[0]
-                                       .size()); // divide by number of elements to compute the mean
+            (*acc)[s] += rand_proj[s][i * this->sketch_dim + j] * sketch[j];
         }
+    }
 
-        return v;
+    /** Returns the flattened sketch from the projections of #num_sketches sketches */
+    std::vector<double> finish(std::vector<double> acc, size_t num_sketches) const {
+        if (num_sketches > 0) {
+            for (double &v : acc) {
+                // divide by number of elements to compute the mean
+                v /= (double)(num_sketches * sketch_dim);
+            }
+        }
+        return acc;
     }
 
     static double dist(const std::vector<double> &v1, const std::vector<double> &v2) {
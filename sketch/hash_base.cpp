@@ -1,5 +1,7 @@
 #include "sketch/hash_base.hpp"
 
+#include <stdexcept>
+
 namespace ts {
 
 HashAlgorithm parse_hash_algorithm(const std::string &name) {
@@ -12,7 +14,10 @@ HashAlgorithm parse_hash_algorithm(const std::string &name) {
     if (name == "murmur") {
         return HashAlgorithm::murmur;
     }
-    assert(false);
+    if (name == "mix32") {
+        return HashAlgorithm::mix32;
+    }
+    throw std::invalid_argument("Unknown hash algorithm: " + name);
 }
 
 } // namespace ts
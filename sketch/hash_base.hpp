@@ -1,5 +1,6 @@
 #pragma once
 
+#include "sketch/multi_hash.hpp"
 #include "sketch/sketch_base.hpp"
 #include "util/timer.hpp"
 #include "util/utils.hpp"
@@ -7,27 +8,54 @@
 #include <murmur_hash3.hpp>
 
 #include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <immintrin.h>
 #include <random>
+#include <type_traits>
 #include <unordered_map>
-#include <unordered_set>
 
 namespace ts {
 
-enum class HashAlgorithm { uniform, crc32, murmur };
+enum class HashAlgorithm { uniform, crc32, murmur, mix32 };
 
+/** Returns the hash algorithm with the given name, i.e. "uniform", "crc32", "murmur" or "mix32" */
 HashAlgorithm parse_hash_algorithm(const std::string &name);
 
+/**
+ * Calls f(std::integral_constant<HashAlgorithm, a>()) for the given runtime value a, so that the
+ * hash algorithm chosen e.g. by a command line flag can instantiate the sketch classes, which take
+ * it as a template parameter.
+ */
+template <typename F>
+void run_function_on_hash_algorithm(HashAlgorithm hash_algorithm, F f) {
+    switch (hash_algorithm) {
+        case HashAlgorithm::uniform:
+            f(std::integral_constant<HashAlgorithm, HashAlgorithm::uniform>());
+            return;
+        case HashAlgorithm::crc32:
+            f(std::integral_constant<HashAlgorithm, HashAlgorithm::crc32>());
+            return;
+        case HashAlgorithm::murmur:
+            f(std::integral_constant<HashAlgorithm, HashAlgorithm::murmur>());
+            return;
+        case HashAlgorithm::mix32:
+            f(std::integral_constant<HashAlgorithm, HashAlgorithm::mix32>());
+            return;
+    }
+}
+
 /**
  * @tparam T the type of elements in the hash.
+ * @tparam kHashAlgorithm the algorithm of the hash functions; as a template parameter, #hash can
+ * be inlined into the inner loops of the sketches without a branch per call
  */
-template <typename T>
+template <typename T, HashAlgorithm kHashAlgorithm = HashAlgorithm::murmur>
 class HashBase : public SketchBase<std::vector<T>, true> {
   public:
     HashBase(T set_size,
              size_t sketch_dim,
              size_t hash_size,
-             HashAlgorithm hash_algorithm,
              uint32_t seed,
              const std::string &name = "HashBase",
              size_t kmer_size = 1)
@@ -35,7 +63,6 @@ class HashBase : public SketchBase<std::vector<T>, true> {
           set_size(set_size),
           sketch_dim(sketch_dim),
           hash_size(2 * hash_size),
-          hash_algorithm(hash_algorithm),
           rand(0, this->hash_size - 1),
           rng(seed) {
         init();
@@ -44,10 +71,27 @@ class HashBase : public SketchBase<std::vector<T>, true> {
     void init() {
         hash_seed = rand(rng);
         hash_seed2 = rand(rng);
-        hashes.assign(sketch_dim, {});
-        hash_values.assign(sketch_dim, {});
+        hashes.clear();
+        half_bits = 1;
+        while (2 * half_bits < 64 && (uint64_t(1) << (2 * half_bits)) < this->hash_size) {
+            half_bits++;
+        }
+        round_keys.resize(sketch_dim * kFeistelRounds);
+        for (uint64_t &key : round_keys) {
+            key = (uint64_t(rng()) << 32) | rng();
+        }
+        mix_mul.resize(sketch_dim);
+        mix_add.resize(sketch_dim);
+        for (size_t k = 0; k < sketch_dim; ++k) {
+            mix_mul[k] = rng() | 1; // odd, so that the multiplication is a bijection
+            mix_add[k] = rng();
+        }
     }
 
+    /**
+     * Replaces the uniform hash functions with the given permutations, which must contain all the
+     * keys that will be hashed.
+     */
     void set_hashes_for_testing(const std::vector<std::unordered_map<T, T>> &h) { hashes = h; }
 
   protected:
@@ -55,60 +99,88 @@ class HashBase : public SketchBase<std::vector<T>, true> {
     size_t sketch_dim;
     size_t hash_size;
 
+    /** The multipliers and increments of the mix32 hash functions, see ts::mix32 */
+    std::vector<uint32_t> mix_mul;
+    std::vector<uint32_t> mix_add;
+
     /**
      * Returns the hash value for the given #key of the #index-th hash function.
      */
-    T hash(uint64_t index, uint64_t key) {
-        switch (hash_algorithm) {
-            case HashAlgorithm::uniform: {
-                T val;
-                // TODO multiple read Semaphore instead of critical
-#pragma omp critical
-                {
-                    auto [it, inserted] = hashes[index].insert({ key, -1 });
-                    if (!inserted) {
-                        val = it->second;
-                    } else {
-                        do {
-                            val = rand(rng);
-                        } while (!hash_values[index].insert(val).second);
-                        it->second = val;
-                    }
-                }
-                assert(val >= 0 && val < hash_size
-                       && " Hash values are not in [0,set_size-1] range");
-                return val;
-            }
-            case HashAlgorithm::crc32: {
-                uint32_t val = _mm_crc32_u32(hash_seed, (uint32_t)key);
-                val =  _mm_crc32_u32((uint32_t)val, (uint32_t)index);
-                if constexpr (sizeof(T) <= 4) {
-                   return static_cast<T>(val);
-                } else if constexpr (sizeof(T) <=8) {
-                    uint32_t val2 = _mm_crc32_u32(hash_seed2, (uint32_t)key);
-                    val2 =  _mm_crc32_u32((uint32_t)val2, (uint32_t)index);
-                    return (val << 4) | val2;
-                }
+    T hash(uint64_t index, uint64_t key) const {
+        if constexpr (kHashAlgorithm == HashAlgorithm::uniform) {
+            if (!hashes.empty()) { // set by set_hashes_for_testing
+                auto it = hashes[index].find(key);
+                assert(it != hashes[index].end() && "Key missing from the testing hashes");
+                return it->second;
             }
-            case HashAlgorithm::murmur: {
-                uint64_t to_hash[] = { index, key };
-                uint8_t result[16];
-                MurmurHash3_x86_128(to_hash, 16, hash_seed, result);
-                T v = *((T *)result);
-                return v;
+            T val = permute(index, key);
+            assert(val >= 0 && val < hash_size && " Hash values are not in [0,set_size-1] range");
+            return val;
+        } else if constexpr (kHashAlgorithm == HashAlgorithm::crc32) {
+            uint32_t val = _mm_crc32_u32(hash_seed, (uint32_t)key);
+            val = _mm_crc32_u32((uint32_t)val, (uint32_t)index);
+            if constexpr (sizeof(T) <= 4) {
+                return static_cast<T>(val);
+            } else {
+                uint32_t val2 = _mm_crc32_u32(hash_seed2, (uint32_t)key);
+                val2 = _mm_crc32_u32((uint32_t)val2, (uint32_t)index);
+                return (val << 4) | val2;
             }
-            default:
-                return -1;
+        } else if constexpr (kHashAlgorithm == HashAlgorithm::mix32) {
+            return static_cast<T>(mix32(fold32(key), mix_mul[index], mix_add[index]));
+        } else {
+            static_assert(kHashAlgorithm == HashAlgorithm::murmur, "Unknown hash algorithm");
+            uint64_t to_hash[] = { index, key };
+            uint8_t result[16];
+            MurmurHash3_x86_128(to_hash, 16, hash_seed, result);
+            T v = *((T *)result);
+            return v;
         }
     }
 
   private:
-    HashAlgorithm hash_algorithm;
+    /** The number of rounds of the Feistel networks of the uniform hash functions */
+    static constexpr uint32_t kFeistelRounds = 4;
+
+    /** The finalizer of splitmix64, a bijection of 64 bit integers with good avalanche */
+    static uint64_t mix64(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    /**
+     * Returns the image of #key under the #index-th uniform hash function, a keyed permutation of
+     * [0, hash_size). A Feistel network on two halves of #half_bits bits is a bijection of
+     * [0, 4^half_bits) for any round function. Applying it repeatedly until the result is smaller
+     * than #hash_size (cycle walking) restricts it to a bijection of [0, hash_size). Since
+     * 4^half_bits < 4*hash_size, this takes fewer than 4 applications on average. Unlike a table
+     * of random values, this needs no memory per key and no lock, so it can be called from
+     * several threads at once.
+     */
+    uint64_t permute(uint64_t index, uint64_t key) const {
+        assert(index < sketch_dim && key < hash_size && "Key out of the permuted range");
+        const uint64_t mask = (uint64_t(1) << half_bits) - 1;
+        const uint64_t *keys = &round_keys[index * kFeistelRounds];
+        do {
+            uint64_t left = key >> half_bits;
+            uint64_t right = key & mask;
+            for (uint32_t r = 0; r < kFeistelRounds; ++r) {
+                const uint64_t next = left ^ (mix64(right ^ keys[r]) & mask);
+                left = right;
+                right = next;
+            }
+            key = (left << half_bits) | right;
+        } while (key >= hash_size);
+        return key;
+    }
 
-    /** Contains the sketch_dim permutations (hashes) that are used to compute the min-hash */
+    /** Overrides the uniform hash functions if not empty, see #set_hashes_for_testing */
     std::vector<std::unordered_map<T, T>> hashes;
-    /** Contains the values used so far for each on-demand permutation */
-    std::vector<std::unordered_set<T>> hash_values;
+    /** The number of bits of each half of the input of the Feistel networks, see #permute */
+    uint32_t half_bits;
+    /** round_keys[index*kFeistelRounds + r] is the key of round r of the index-th permutation */
+    std::vector<uint64_t> round_keys;
     std::uniform_int_distribution<T> rand;
     std::mt19937 rng;
     uint32_t hash_seed;
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "hash_base.hpp"
+
+#include "util/timer.hpp"
+#include "util/utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace ts { // ts = Tensor Sketch
+
+/**
+ * Implements weighted min-hash sketching with Improved Consistent Weighted Sampling (ICWS), as
+ * described in Ioffe, ICDM 2010:
+ * https://static.googleusercontent.com/media/research.google.com/en//pubs/archive/36928.pdf
+ * The weight of a k-mer is its number of occurrences in the sequence.
+ * For each hash function k and distinct k-mer s with weight w_s, ICWS draws r, c ~ Gamma(2,1) and
+ * beta ~ U(0,1) as a function of (k, s) only, and computes t = floor(ln(w_s)/r + beta) and
+ * a = c / exp(r*(t - beta + 1)). The k-th component of the sketch is the k-mer with the smallest
+ * a. Only the k-mer is kept, not t ("0-bit CWS", Li, KDD 2015), so the sketch has the same type
+ * and distance as WeightedMinHash's. Two sketches agree in a component with probability (very
+ * close to) the weighted Jaccard similarity sum_s min(w_s, w'_s) / sum_s max(w_s, w'_s).
+ * Unlike WeightedMinHash, which hashes every occurrence of every k-mer with every hash function,
+ * the multiplicities are counted once, and there is one sample per distinct k-mer and hash
+ * function, so repetitive sequences are cheap to sketch and there is no maximum multiplicity.
+ * @tparam T the type of S's elements
+ * @tparam kHashAlgorithm the algorithm of the hash functions that seed the samples
+ */
+template <class T, HashAlgorithm kHashAlgorithm = HashAlgorithm::murmur>
+class ConsistentWeightedMinHash : public HashBase<T, kHashAlgorithm> {
+  public:
+    /**
+     * @param set_size the number of elements in S,
+     * @param sketch_dim the number of components (elements) in the sketch vector.
+     * @param seed the seed to initialize the random number generator used for the random hash
+     * functions.
+     */
+    ConsistentWeightedMinHash(T set_size,
+                              size_t sketch_dim,
+                              uint32_t seed,
+                              const std::string &name = "ICWS",
+                              size_t kmer_size = 1)
+        : HashBase<T, kHashAlgorithm>(set_size, sketch_dim, set_size, seed, name, kmer_size) {}
+
+    std::vector<T> compute(const std::vector<T> &kmers) {
+        Timer timer("icws_minhash");
+        std::vector<T> sketch(this->sketch_dim);
+        if (kmers.empty()) {
+            return sketch;
+        }
+
+        // the distinct k-mers and the logarithms of their multiplicities
+        static thread_local std::vector<T> sorted;
+        static thread_local std::vector<std::pair<T, double>> weights;
+        sorted = kmers;
+        std::sort(sorted.begin(), sorted.end());
+        weights.clear();
+        for (size_t i = 0; i < sorted.size();) {
+            size_t j = i + 1;
+            while (j < sorted.size() && sorted[j] == sorted[i]) {
+                j++;
+            }
+            weights.emplace_back(sorted[i], std::log(static_cast<double>(j - i)));
+            i = j;
+        }
+
+        for (size_t si = 0; si < this->sketch_dim; si++) {
+            T min_char = T(0);
+            double min_log_a = std::numeric_limits<double>::infinity();
+            for (const auto &[s, log_weight] : weights) {
+                // the three random variables of the sample, seeded by the (si, s) hash
+                uint64_t state = this->hash(si, s);
+                const double r = -std::log(uniform(&state) * uniform(&state));
+                const double c = -std::log(uniform(&state) * uniform(&state));
+                const double beta = uniform(&state);
+                const double t = std::floor(log_weight / r + beta);
+                const double log_a = std::log(c) - r * (t - beta + 1);
+                if (log_a < min_log_a) {
+                    min_log_a = log_a;
+                    min_char = s;
+                }
+            }
+            sketch[si] = min_char;
+        }
+        return sketch;
+    }
+
+    /**
+     * Computes the ICWS sketch for the given sequence.
+     * @param sequence the sequence to compute the sketch for
+     * @param k-mer length; the sequence will be transformed into k-mers and the k-mers will be
+     * hashed
+     * @param number of characters in the alphabet over which sequence is defined
+     * @return the ICWS sketch of #sequence
+     * @tparam C the type of characters in #sequence
+     */
+    template <typename C>
+    std::vector<T> compute(const std::vector<C> &sequence, uint32_t k, uint32_t alphabet_size) {
+        std::vector<T> kmers = seq2kmer<C, T>(sequence, k, alphabet_size);
+        return compute(kmers);
+    }
+
+    static T dist(const std::vector<T> &a, const std::vector<T> &b) {
+        Timer timer("icws_minhash_dist");
+        return hamming_dist(a, b);
+    }
+
+  private:
+    /**
+     * Returns the next value of the splitmix64 sequence starting at #state, as a double in (0, 1).
+     */
+    static double uniform(uint64_t *state) {
+        uint64_t x = (*state += 0x9e3779b97f4a7c15ULL);
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        // the top 53 bits, shifted by half a unit so that 0 is excluded
+        return ((x >> 11) + 0.5) * 0x1.0p-53;
+    }
+};
+
+} // namespace ts
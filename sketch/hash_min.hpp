@@ -19,9 +19,10 @@ namespace ts { // ts = Tensor Sketch
  * the elements in S.
  * This class assumes that S= {0,1,2....,#set_size}.
  * @tparam T the type of S's elements.
+ * @tparam kHashAlgorithm the algorithm of the hash functions h_k
  */
-template <class T>
-class MinHash : public HashBase<T> {
+template <class T, HashAlgorithm kHashAlgorithm = HashAlgorithm::murmur>
+class MinHash : public HashBase<T, kHashAlgorithm> {
   public:
     /**
      * Constructs a min-hasher for the given alphabet size which constructs sketches of the set size
@@ -33,11 +34,10 @@ class MinHash : public HashBase<T> {
      */
     MinHash(T set_size,
             size_t sketch_dim,
-            HashAlgorithm hash_algorithm,
             uint32_t seed,
             const std::string &name = "MH",
             size_t kmer_size = 1)
-        : HashBase<T>(set_size, sketch_dim, set_size, hash_algorithm, seed, name, kmer_size) {}
+        : HashBase<T, kHashAlgorithm>(set_size, sketch_dim, set_size, seed, name, kmer_size) {}
 
     /**
      * Computes the min-hash sketch for the given kmers.
@@ -51,6 +51,23 @@ class MinHash : public HashBase<T> {
             return sketch;
         }
 
+        if constexpr (kHashAlgorithm == HashAlgorithm::mix32) {
+            // all hash functions at once, in a single vectorized pass over the kmers
+            static thread_local std::vector<uint32_t> keys;
+            static thread_local std::vector<uint32_t> argmin;
+            keys.resize(kmers.size());
+            argmin.resize(this->sketch_dim);
+            for (size_t i = 0; i < kmers.size(); ++i) {
+                keys[i] = fold32(kmers[i]);
+            }
+            min_hash_mix32(keys.data(), keys.size(), this->mix_mul.data(), this->mix_add.data(),
+                           this->sketch_dim, argmin.data());
+            for (size_t si = 0; si < this->sketch_dim; si++) {
+                sketch[si] = kmers[argmin[si]];
+            }
+            return sketch;
+        }
+
         for (size_t si = 0; si < this->sketch_dim; si++) {
             T min_char = T(0);
             T min_rank = std::numeric_limits<T>::max();
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "hash_base.hpp"
+
+#include "util/timer.hpp"
+#include "util/utils.hpp"
+
+#include <cstdint>
+
+namespace ts { // ts = Tensor Sketch
+
+/**
+ * Implements one permutation hashing with optimal densification, as described in
+ * https://arxiv.org/abs/1703.04664 (Shrivastava, ICML 2017).
+ * Instead of evaluating #sketch_dim hash functions on every k-mer, as MinHash does, each k-mer is
+ * hashed once, and the hash h selects the bin h % #sketch_dim and the rank h / #sketch_dim within
+ * the bin. Each bin keeps the k-mer with the smallest rank. Bins that received no k-mer are filled
+ * by copying a non-empty bin chosen by a fixed sequence of random probes per bin. The probes don't
+ * depend on the sequence, so two sequences with similar k-mer sets fill their empty bins similarly.
+ * As for MinHash, the probability that two sketches agree in a bin is the Jaccard similarity of
+ * the k-mer sets, but computing a sketch costs O(n + #sketch_dim) hash evaluations instead of
+ * O(n * #sketch_dim), as long as n is not much smaller than #sketch_dim.
+ * @tparam T the type of S's elements.
+ * @tparam kHashAlgorithm the algorithm of the hash function
+ */
+template <class T, HashAlgorithm kHashAlgorithm = HashAlgorithm::murmur>
+class OnePermMinHash : public HashBase<T, kHashAlgorithm> {
+  public:
+    /**
+     * @param set_size the number of elements in S,
+     * @param sketch_dim the number of bins (elements) in the sketch vector.
+     * @param seed the seed to initialize the random number generator used for the random hash
+     * functions.
+     */
+    OnePermMinHash(T set_size,
+                   size_t sketch_dim,
+                   uint32_t seed,
+                   const std::string &name = "OPH",
+                   size_t kmer_size = 1)
+        : HashBase<T, kHashAlgorithm>(set_size, sketch_dim, set_size, seed, name, kmer_size) {
+        assert(sketch_dim > 0 && "The sketch needs at least one bin");
+    }
+
+    /**
+     * Computes the one permutation min-hash sketch for the given kmers.
+     * @param kmers kmers extracted from a sequence
+     * @return the densified sketch of #kmers, or #sketch_dim zeros if #kmers is empty
+     */
+    std::vector<T> compute(const std::vector<T> &kmers) {
+        Timer timer("one_perm_minhash");
+        const size_t num_bins = this->sketch_dim;
+        std::vector<T> sketch(num_bins);
+        if (kmers.empty()) {
+            return sketch;
+        }
+
+        static thread_local std::vector<uint64_t> min_ranks;
+        static thread_local std::vector<uint8_t> filled;
+        min_ranks.resize(num_bins);
+        filled.assign(num_bins, false);
+        for (auto s : kmers) {
+            const uint64_t hash = this->hash(0, s);
+            const size_t bin = hash % num_bins;
+            const uint64_t rank = hash / num_bins;
+            if (!filled[bin] || rank < min_ranks[bin]) {
+                filled[bin] = true;
+                min_ranks[bin] = rank;
+                sketch[bin] = s;
+            }
+        }
+
+        // optimal densification: copy the k-mer of the first non-empty bin probed; only bins that
+        // are non-empty after hashing are copied, so the result doesn't depend on the bin order
+        for (size_t bin = 0; bin < num_bins; ++bin) {
+            if (filled[bin]) {
+                continue;
+            }
+            for (uint32_t attempt = 0;; ++attempt) {
+                const size_t from = probe(bin, attempt);
+                if (filled[from]) {
+                    sketch[bin] = sketch[from];
+                    break;
+                }
+            }
+        }
+        return sketch;
+    }
+
+    /**
+     * Computes the one permutation min-hash sketch for the given sequence.
+     * @param sequence the sequence to compute the min-hash for
+     * @param k-mer length; the sequence will be transformed into k-mers and the k-mers will be
+     * hashed
+     * @param number of characters in the alphabet over which sequence is defined
+     * @return the one permutation min-hash sketch of sequence
+     * @tparam C the type of characters in the sequence
+     */
+    template <typename C>
+    std::vector<T> compute(const std::vector<C> &sequence, uint32_t k, uint32_t alphabet_size) {
+        std::vector<T> kmers = seq2kmer<C, T>(sequence, k, alphabet_size);
+        return compute(kmers);
+    }
+
+    static T dist(const std::vector<T> &a, const std::vector<T> &b) {
+        Timer timer("one_perm_minhash_dist");
+        return hamming_dist(a, b);
+    }
+
+  private:
+    /**
+     * Returns the bin probed by the #attempt-th try to fill the empty bin #bin. The probes are a
+     * random function of (bin, attempt), determined by the seed but not by the sketched sequence.
+     */
+    size_t probe(size_t bin, uint32_t attempt) const {
+        const uint32_t key = static_cast<uint32_t>(attempt * this->sketch_dim + bin);
+        return mix32(key, this->mix_mul[0], this->mix_add[0]) % this->sketch_dim;
+    }
+};
+
+} // namespace ts
@@ -15,9 +15,10 @@ namespace ts { // ts = Tensor Sketch
  * https://www.ncbi.nlm.nih.gov/pmc/articles/PMC6612865/
  *
  * @tparam T the type of element in the sequences to be sketched
+ * @tparam kHashAlgorithm the algorithm of the hash functions
  */
-template <class T>
-class OrderedMinHash : public HashBase<T> {
+template <class T, HashAlgorithm kHashAlgorithm = HashAlgorithm::murmur>
+class OrderedMinHash : public HashBase<T, kHashAlgorithm> {
   public:
     /**
      * @param set_size the number of elements in S
@@ -31,11 +32,15 @@ class OrderedMinHash : public HashBase<T> {
                    size_t sketch_dim,
                    size_t max_len,
                    size_t tup_len,
-                   HashAlgorithm hash_algorithm,
                    uint32_t seed,
                    const std::string &name = "OMH",
                    size_t kmer_size = 1)
-        : HashBase<T>(set_size, sketch_dim, set_size * max_len, hash_algorithm, seed, name, kmer_size),
+        : HashBase<T, kHashAlgorithm>(set_size,
+                                      sketch_dim,
+                                      set_size * max_len,
+                                      seed,
+                                      name,
+                                      kmer_size),
           max_len(max_len),
           tup_len(tup_len) {}
 
@@ -15,6 +15,7 @@ namespace ts { // ts = Tensor Sketch
  * Naive implementation of weighted min-hash sketching. For more efficient implementations, see
  * https://static.googleusercontent.com/media/research.google.com/en//pubs/archive/36928.pdf and
  * https://www.microsoft.com/en-us/research/wp-content/uploads/2010/06/ConsistentWeightedSampling2.pdf
+ * The former is implemented by ConsistentWeightedMinHash.
  *
  * Given a set S, and a sequence s=s1...sn with elements from S, this class computes a vector
  * {hmin_1(s), hmin_2(s), ..., hmin_sketch_size(s)}, where hmin_k(s)=s_i, such that h_k(s_i, #s_i)
@@ -22,9 +23,10 @@ namespace ts { // ts = Tensor Sketch
  * h_k:Sx{1..n} -> {1..#set_size} is a random permuation of the elements in S and #s_i denotes the
  * number of occurences of s_i in the sequence s.
  * @tparam T the type of S's elements
+ * @tparam kHashAlgorithm the algorithm of the hash functions h_k
  */
-template <class T>
-class WeightedMinHash : public HashBase<T> {
+template <class T, HashAlgorithm kHashAlgorithm = HashAlgorithm::murmur>
+class WeightedMinHash : public HashBase<T, kHashAlgorithm> {
   public:
     /**
      * Constructs a weighted min-hasher for the given alphabet size which constructs sketches of the
@@ -38,11 +40,15 @@ class WeightedMinHash : public HashBase<T> {
     WeightedMinHash(T set_size,
                     size_t sketch_dim,
                     size_t max_len,
-                    HashAlgorithm hash_algorithm,
                     uint32_t seed,
                     const std::string &name = "WMH",
                     size_t kmer_size = 1)
-        : HashBase<T>(set_size, sketch_dim, max_len * set_size, hash_algorithm, seed, name, kmer_size),
+        : HashBase<T, kHashAlgorithm>(set_size,
+                                      sketch_dim,
+                                      max_len * set_size,
+                                      seed,
+                                      name,
+                                      kmer_size),
           max_len(max_len) {}
 
     std::vector<T> compute(const std::vector<T> &kmers) {
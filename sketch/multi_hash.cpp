@@ -0,0 +1,164 @@
+#include "sketch/multi_hash.hpp"
+
+#include "sketch/shift_sum.hpp"
+
+#include <immintrin.h>
+
+#include <cassert>
+#include <limits>
+
+namespace ts {
+
+namespace {
+
+/**
+ * Number of registers of hash functions kept in flight by the vectorized kernels: 32 (AVX2) or 64
+ * (AVX-512) functions are evaluated per key, with their running minima held in registers.
+ */
+constexpr size_t kTileVectors = 4;
+
+void min_hash_scalar(const uint32_t *keys,
+                     size_t num_keys,
+                     const uint32_t *a,
+                     const uint32_t *b,
+                     size_t num_functions,
+                     uint32_t *argmin) {
+    for (size_t k = 0; k < num_functions; ++k) {
+        uint32_t min_hash = mix32(keys[0], a[k], b[k]);
+        argmin[k] = 0;
+        for (size_t i = 1; i < num_keys; ++i) {
+            const uint32_t hash = mix32(keys[i], a[k], b[k]);
+            if (hash < min_hash) {
+                min_hash = hash;
+                argmin[k] = i;
+            }
+        }
+    }
+}
+
+/** Computes #mix32 in each lane of #x, with the multipliers #a and increments #b */
+__attribute__((target("avx2"))) inline __m256i mix32_avx2(__m256i x, __m256i a, __m256i b) {
+    __m256i h = _mm256_add_epi32(_mm256_mullo_epi32(x, a), b);
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0x85ebca6b));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0xc2b2ae35));
+    return _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+}
+
+/** Min-hash of the V*8 functions starting at a, b, see #min_hash_mix32 */
+template <size_t V>
+__attribute__((target("avx2"))) void min_hash_avx2(const uint32_t *keys,
+                                                   size_t num_keys,
+                                                   const uint32_t *a,
+                                                   const uint32_t *b,
+                                                   uint32_t *argmin) {
+    // AVX2 only compares signed integers: flipping the top bit maps the unsigned order onto the
+    // signed one
+    const __m256i bias = _mm256_set1_epi32(std::numeric_limits<int32_t>::min());
+    __m256i va[V], vb[V], vmin[V], vargmin[V];
+    for (size_t v = 0; v < V; ++v) {
+        va[v] = _mm256_loadu_si256((const __m256i *)(a + 8 * v));
+        vb[v] = _mm256_loadu_si256((const __m256i *)(b + 8 * v));
+        vmin[v] = _mm256_set1_epi32(std::numeric_limits<int32_t>::max());
+        vargmin[v] = _mm256_setzero_si256();
+    }
+    for (size_t i = 0; i < num_keys; ++i) {
+        const __m256i x = _mm256_set1_epi32(keys[i]);
+        const __m256i index = _mm256_set1_epi32(i);
+        for (size_t v = 0; v < V; ++v) {
+            const __m256i hash = _mm256_xor_si256(mix32_avx2(x, va[v], vb[v]), bias);
+            // strictly smaller, so that the first position of the minimum is kept
+            const __m256i smaller = _mm256_cmpgt_epi32(vmin[v], hash);
+            vmin[v] = _mm256_min_epi32(vmin[v], hash);
+            vargmin[v] = _mm256_blendv_epi8(vargmin[v], index, smaller);
+        }
+    }
+    for (size_t v = 0; v < V; ++v) {
+        _mm256_storeu_si256((__m256i *)(argmin + 8 * v), vargmin[v]);
+    }
+}
+
+/**
+ * Computes h ^ (h >> shift) in each lane. Uses the zero-masked shift, because GCC warns about the
+ * undefined source register of the unmasked _mm512_srli_epi32.
+ */
+template <unsigned int shift>
+__attribute__((target("avx512f"))) inline __m512i xorshift_avx512(__m512i h) {
+    return _mm512_xor_si512(h, _mm512_maskz_srli_epi32(0xFFFF, h, shift));
+}
+
+/** Computes #mix32 in each lane of #x, with the multipliers #a and increments #b */
+__attribute__((target("avx512f"))) inline __m512i mix32_avx512(__m512i x, __m512i a, __m512i b) {
+    __m512i h = _mm512_add_epi32(_mm512_mullo_epi32(x, a), b);
+    h = xorshift_avx512<16>(h);
+    h = _mm512_mullo_epi32(h, _mm512_set1_epi32(0x85ebca6b));
+    h = xorshift_avx512<13>(h);
+    h = _mm512_mullo_epi32(h, _mm512_set1_epi32(0xc2b2ae35));
+    return xorshift_avx512<16>(h);
+}
+
+/** Min-hash of the V*16 functions starting at a, b, see #min_hash_mix32 */
+template <size_t V>
+__attribute__((target("avx512f"))) void min_hash_avx512(const uint32_t *keys,
+                                                        size_t num_keys,
+                                                        const uint32_t *a,
+                                                        const uint32_t *b,
+                                                        uint32_t *argmin) {
+    __m512i va[V], vb[V], vmin[V], vargmin[V];
+    for (size_t v = 0; v < V; ++v) {
+        va[v] = _mm512_loadu_si512(a + 16 * v);
+        vb[v] = _mm512_loadu_si512(b + 16 * v);
+        vmin[v] = _mm512_set1_epi32(-1);
+        vargmin[v] = _mm512_setzero_si512();
+    }
+    for (size_t i = 0; i < num_keys; ++i) {
+        const __m512i x = _mm512_set1_epi32(keys[i]);
+        const __m512i index = _mm512_set1_epi32(i);
+        for (size_t v = 0; v < V; ++v) {
+            const __m512i hash = mix32_avx512(x, va[v], vb[v]);
+            // strictly smaller, so that the first position of the minimum is kept
+            const __mmask16 smaller = _mm512_cmplt_epu32_mask(hash, vmin[v]);
+            vmin[v] = _mm512_mask_mov_epi32(vmin[v], smaller, hash);
+            vargmin[v] = _mm512_mask_mov_epi32(vargmin[v], smaller, index);
+        }
+    }
+    for (size_t v = 0; v < V; ++v) {
+        _mm512_storeu_si512(argmin + 16 * v, vargmin[v]);
+    }
+}
+
+} // namespace
+
+void min_hash_mix32(const uint32_t *keys,
+                    size_t num_keys,
+                    const uint32_t *a,
+                    const uint32_t *b,
+                    size_t num_functions,
+                    uint32_t *argmin) {
+    assert(num_keys > 0 && num_keys <= std::numeric_limits<uint32_t>::max());
+    size_t k = 0; // the first function not computed yet
+    switch (simd_level()) {
+        case SimdLevel::avx512:
+            for (; k + kTileVectors * 16 <= num_functions; k += kTileVectors * 16) {
+                min_hash_avx512<kTileVectors>(keys, num_keys, a + k, b + k, argmin + k);
+            }
+            for (; k + 16 <= num_functions; k += 16) {
+                min_hash_avx512<1>(keys, num_keys, a + k, b + k, argmin + k);
+            }
+            break;
+        case SimdLevel::avx2:
+            for (; k + kTileVectors * 8 <= num_functions; k += kTileVectors * 8) {
+                min_hash_avx2<kTileVectors>(keys, num_keys, a + k, b + k, argmin + k);
+            }
+            for (; k + 8 <= num_functions; k += 8) {
+                min_hash_avx2<1>(keys, num_keys, a + k, b + k, argmin + k);
+            }
+            break;
+        default:
+            break;
+    }
+    min_hash_scalar(keys, num_keys, a + k, b + k, num_functions - k, argmin + k);
+}
+
+} // namespace ts
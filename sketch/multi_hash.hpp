@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ts { // ts = Tensor Sketch
+
+/**
+ * Folds a 64 bit key into 32 bits for the mix32 hash family. Keys smaller than 2^32, e.g. k-mers of
+ * up to 16 nucleotides, are kept as they are, so they never collide.
+ */
+inline uint32_t fold32(uint64_t key) {
+    return static_cast<uint32_t>(key)
+            ^ static_cast<uint32_t>(((key >> 32) * 0x9e3779b97f4a7c15ULL) >> 32);
+}
+
+/**
+ * The k-th function of the mix32 hash family: the affine map a[k]*x + b[k] followed by the
+ * finalizer of MurmurHash3. For odd a[k], both steps are bijections of the 32 bit integers, so
+ * distinct keys never have the same hash. Only 32 bit multiplications, shifts and xors are used,
+ * so 8 (AVX2) or 16 (AVX-512) functions can be evaluated in one register.
+ */
+inline uint32_t mix32(uint32_t x, uint32_t a, uint32_t b) {
+    uint32_t h = a * x + b;
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+ * Computes the min-hash of #keys for the #num_functions functions mix32(., a[k], b[k]). Each key
+ * is hashed by 8 (AVX2) or 16 (AVX-512) functions per instruction, depending on simd_level(), and
+ * compared against running minima held in registers. Up to 32 (AVX2) or 64 (AVX-512) functions
+ * are computed in a single pass over #keys, more functions in one pass per 32 or 64.
+ * @param keys the keys, already folded to 32 bits by #fold32
+ * @param num_keys the number of keys, must be positive and smaller than 2^32
+ * @param[out] argmin argmin[k] is set to the first position i for which
+ * mix32(keys[i], a[k], b[k]) is minimal
+ */
+void min_hash_mix32(const uint32_t *keys,
+                    size_t num_keys,
+                    const uint32_t *a,
+                    const uint32_t *b,
+                    size_t num_functions,
+                    uint32_t *argmin);
+
+} // namespace ts
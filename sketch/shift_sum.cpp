@@ -0,0 +1,388 @@
+#include "sketch/shift_sum.hpp"
+
+#include <immintrin.h>
+
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+
+namespace ts {
+
+namespace {
+
+/** Signature of the kernels computing out[i] = keep*a[i] + z*b[i] for i in [0, len). */
+template <class T>
+using AxpbyFn = void (*)(T *, const T *, const T *, size_t, T, T);
+
+/** Signature of the lane-interleaved kernels, see #shift_sum_lanes. */
+template <class T>
+using LanesFn = void (*)(T *, const T *, size_t, const uint32_t *, const T *, const T *);
+
+template <class T>
+void axpby_scalar(T *out, const T *a, const T *b, size_t len, T keep, T z) {
+    for (size_t i = 0; i < len; ++i) {
+        out[i] = keep * a[i] + z * b[i];
+    }
+}
+
+__attribute__((target("avx2,fma"))) void
+axpby_avx2(double *out, const double *a, const double *b, size_t len, double keep, double z) {
+    const __m256d vkeep = _mm256_set1_pd(keep);
+    const __m256d vz = _mm256_set1_pd(z);
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        __m256d va = _mm256_loadu_pd(a + i);
+        __m256d vb = _mm256_loadu_pd(b + i);
+        _mm256_storeu_pd(out + i, _mm256_fmadd_pd(vz, vb, _mm256_mul_pd(vkeep, va)));
+    }
+    // use the same fused operation for the tail, so that results don't depend on the alignment
+    for (; i < len; ++i) {
+        out[i] = std::fma(z, b[i], keep * a[i]);
+    }
+}
+
+__attribute__((target("avx2,fma"))) void
+axpby_avx2(float *out, const float *a, const float *b, size_t len, float keep, float z) {
+    const __m256 vkeep = _mm256_set1_ps(keep);
+    const __m256 vz = _mm256_set1_ps(z);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        __m256 va = _mm256_loadu_ps(a + i);
+        __m256 vb = _mm256_loadu_ps(b + i);
+        _mm256_storeu_ps(out + i, _mm256_fmadd_ps(vz, vb, _mm256_mul_ps(vkeep, va)));
+    }
+    for (; i < len; ++i) {
+        out[i] = std::fma(z, b[i], keep * a[i]);
+    }
+}
+
+__attribute__((target("avx512f"))) void
+axpby_avx512(double *out, const double *a, const double *b, size_t len, double keep, double z) {
+    const __m512d vkeep = _mm512_set1_pd(keep);
+    const __m512d vz = _mm512_set1_pd(z);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        __m512d va = _mm512_loadu_pd(a + i);
+        __m512d vb = _mm512_loadu_pd(b + i);
+        _mm512_storeu_pd(out + i, _mm512_fmadd_pd(vz, vb, _mm512_mul_pd(vkeep, va)));
+    }
+    if (i < len) {
+        const __mmask8 mask = (1U << (len - i)) - 1;
+        __m512d va = _mm512_maskz_loadu_pd(mask, a + i);
+        __m512d vb = _mm512_maskz_loadu_pd(mask, b + i);
+        _mm512_mask_storeu_pd(out + i, mask, _mm512_fmadd_pd(vz, vb, _mm512_mul_pd(vkeep, va)));
+    }
+}
+
+__attribute__((target("avx512f"))) void
+axpby_avx512(float *out, const float *a, const float *b, size_t len, float keep, float z) {
+    const __m512 vkeep = _mm512_set1_ps(keep);
+    const __m512 vz = _mm512_set1_ps(z);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m512 va = _mm512_loadu_ps(a + i);
+        __m512 vb = _mm512_loadu_ps(b + i);
+        _mm512_storeu_ps(out + i, _mm512_fmadd_ps(vz, vb, _mm512_mul_ps(vkeep, va)));
+    }
+    if (i < len) {
+        const __mmask16 mask = (1U << (len - i)) - 1;
+        __m512 va = _mm512_maskz_loadu_ps(mask, a + i);
+        __m512 vb = _mm512_maskz_loadu_ps(mask, b + i);
+        _mm512_mask_storeu_ps(out + i, mask, _mm512_fmadd_ps(vz, vb, _mm512_mul_ps(vkeep, va)));
+    }
+}
+
+/** Signature of the kernels computing a[i] += b[i] (or -= if the last argument is set). */
+template <class T>
+using AddFn = void (*)(T *, const T *, size_t, bool);
+
+template <class T>
+void add_scalar(T *a, const T *b, size_t len, bool negate) {
+    if (negate) {
+        for (size_t i = 0; i < len; ++i) {
+            a[i] -= b[i];
+        }
+    } else {
+        for (size_t i = 0; i < len; ++i) {
+            a[i] += b[i];
+        }
+    }
+}
+
+__attribute__((target("avx2"))) void add_avx2(int64_t *a, const int64_t *b, size_t len, bool negate) {
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+        va = negate ? _mm256_sub_epi64(va, vb) : _mm256_add_epi64(va, vb);
+        _mm256_storeu_si256((__m256i *)(a + i), va);
+    }
+    add_scalar(a + i, b + i, len - i, negate);
+}
+
+__attribute__((target("avx2"))) void add_avx2(double *a, const double *b, size_t len, bool negate) {
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4) {
+        __m256d va = _mm256_loadu_pd(a + i);
+        __m256d vb = _mm256_loadu_pd(b + i);
+        _mm256_storeu_pd(a + i, negate ? _mm256_sub_pd(va, vb) : _mm256_add_pd(va, vb));
+    }
+    add_scalar(a + i, b + i, len - i, negate);
+}
+
+__attribute__((target("avx512f"))) void
+add_avx512(int64_t *a, const int64_t *b, size_t len, bool negate) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        __m512i va = _mm512_loadu_si512(a + i);
+        __m512i vb = _mm512_loadu_si512(b + i);
+        _mm512_storeu_si512(a + i, negate ? _mm512_sub_epi64(va, vb) : _mm512_add_epi64(va, vb));
+    }
+    add_scalar(a + i, b + i, len - i, negate);
+}
+
+__attribute__((target("avx512f"))) void
+add_avx512(double *a, const double *b, size_t len, bool negate) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        __m512d va = _mm512_loadu_pd(a + i);
+        __m512d vb = _mm512_loadu_pd(b + i);
+        _mm512_storeu_pd(a + i, negate ? _mm512_sub_pd(va, vb) : _mm512_add_pd(va, vb));
+    }
+    add_scalar(a + i, b + i, len - i, negate);
+}
+
+template <class T>
+void lanes_scalar(T *a, const T *b, size_t len, const uint32_t *shift, const T *keep, const T *w) {
+    constexpr size_t L = kBatchLanes;
+    // row[l] is the row of b read by lane l; it starts at (len-shift[l])%len and wraps around
+    size_t row[L];
+    for (size_t l = 0; l < L; ++l) {
+        row[l] = shift[l] == 0 ? 0 : len - shift[l];
+    }
+    for (size_t i = 0; i < len; ++i) {
+        for (size_t l = 0; l < L; ++l) {
+            a[i * L + l] = keep[l] * a[i * L + l] + w[l] * b[row[l] * L + l];
+            row[l] = row[l] + 1 == len ? 0 : row[l] + 1;
+        }
+    }
+}
+
+/**
+ * Returns the index into b of the first element read by each lane, i.e. row*L + lane, where
+ * row = (len-shift)%len.
+ */
+__attribute__((target("avx2"))) __m256i first_lane_index(size_t len, const uint32_t *shift) {
+    static_assert(kBatchLanes == 8, "The lane indices must fit in one register of 8 int32");
+    const __m256i vlen = _mm256_set1_epi32(len);
+    __m256i row = _mm256_sub_epi32(vlen, _mm256_loadu_si256((const __m256i *)shift));
+    row = _mm256_min_epu32(row, _mm256_sub_epi32(row, vlen));
+    return _mm256_add_epi32(_mm256_slli_epi32(row, 3), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+/**
+ * Advances the lane indices by one row; the unsigned min with idx-end wraps the rows that went past
+ * the end back to the start without a modulo.
+ */
+__attribute__((target("avx2"))) __m256i next_lane_index(__m256i idx, size_t len) {
+    idx = _mm256_add_epi32(idx, _mm256_set1_epi32(kBatchLanes));
+    return _mm256_min_epu32(idx, _mm256_sub_epi32(idx, _mm256_set1_epi32(len * kBatchLanes)));
+}
+
+__attribute__((target("avx2,fma"))) void lanes_avx2(double *a,
+                                                    const double *b,
+                                                    size_t len,
+                                                    const uint32_t *shift,
+                                                    const double *keep,
+                                                    const double *w) {
+    constexpr size_t L = kBatchLanes;
+    const __m256d vkeep_lo = _mm256_loadu_pd(keep), vkeep_hi = _mm256_loadu_pd(keep + 4);
+    const __m256d vw_lo = _mm256_loadu_pd(w), vw_hi = _mm256_loadu_pd(w + 4);
+    // the masked gather with an explicit source avoids reading an undefined register
+    const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    __m256i idx = first_lane_index(len, shift);
+    for (size_t i = 0; i < len; ++i) {
+        double *ai = a + i * L;
+        __m256d vb_lo = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), b,
+                                                 _mm256_castsi256_si128(idx), all, 8);
+        __m256d vb_hi = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), b,
+                                                 _mm256_extracti128_si256(idx, 1), all, 8);
+        __m256d va_lo = _mm256_loadu_pd(ai), va_hi = _mm256_loadu_pd(ai + 4);
+        _mm256_storeu_pd(ai, _mm256_fmadd_pd(vw_lo, vb_lo, _mm256_mul_pd(vkeep_lo, va_lo)));
+        _mm256_storeu_pd(ai + 4, _mm256_fmadd_pd(vw_hi, vb_hi, _mm256_mul_pd(vkeep_hi, va_hi)));
+        idx = next_lane_index(idx, len);
+    }
+}
+
+// 8 float lanes fit in a single AVX2 register, so this kernel is also used at the AVX-512 level
+__attribute__((target("avx2,fma"))) void lanes_avx2(float *a,
+                                                    const float *b,
+                                                    size_t len,
+                                                    const uint32_t *shift,
+                                                    const float *keep,
+                                                    const float *w) {
+    constexpr size_t L = kBatchLanes;
+    const __m256 vkeep = _mm256_loadu_ps(keep);
+    const __m256 vw = _mm256_loadu_ps(w);
+    const __m256 all = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    __m256i idx = first_lane_index(len, shift);
+    for (size_t i = 0; i < len; ++i) {
+        float *ai = a + i * L;
+        __m256 vb = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), b, idx, all, 4);
+        __m256 va = _mm256_loadu_ps(ai);
+        _mm256_storeu_ps(ai, _mm256_fmadd_ps(vw, vb, _mm256_mul_ps(vkeep, va)));
+        idx = next_lane_index(idx, len);
+    }
+}
+
+__attribute__((target("avx512f,avx2"))) void lanes_avx512(double *a,
+                                                          const double *b,
+                                                          size_t len,
+                                                          const uint32_t *shift,
+                                                          const double *keep,
+                                                          const double *w) {
+    constexpr size_t L = kBatchLanes;
+    const __m512d vkeep = _mm512_loadu_pd(keep);
+    const __m512d vw = _mm512_loadu_pd(w);
+    __m256i idx = first_lane_index(len, shift);
+    for (size_t i = 0; i < len; ++i) {
+        double *ai = a + i * L;
+        __m512d vb = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, idx, b, 8);
+        __m512d va = _mm512_loadu_pd(ai);
+        _mm512_storeu_pd(ai, _mm512_fmadd_pd(vw, vb, _mm512_mul_pd(vkeep, va)));
+        idx = next_lane_index(idx, len);
+    }
+}
+
+/** The kernels implemented for a given instruction set and scalar type. */
+template <class T>
+struct Kernels {
+    AxpbyFn<T> axpby;
+    LanesFn<T> lanes;
+};
+
+template <class T>
+Kernels<T> kernels_for(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::avx512:
+            if constexpr (std::is_same_v<T, float>) {
+                return { axpby_avx512, lanes_avx2 };
+            } else {
+                return { axpby_avx512, lanes_avx512 };
+            }
+        case SimdLevel::avx2:
+            return { axpby_avx2, lanes_avx2 };
+        default:
+            return { axpby_scalar<T>, lanes_scalar<T> };
+    }
+}
+
+template <class T>
+AddFn<T> add_kernel_for(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::avx512:
+            return add_avx512;
+        case SimdLevel::avx2:
+            return add_avx2;
+        default:
+            return add_scalar<T>;
+    }
+}
+
+SimdLevel &current_level() {
+    static SimdLevel level = detect_simd_level();
+    return level;
+}
+
+template <class T>
+Kernels<T> &current_kernels() {
+    static Kernels<T> kernels = kernels_for<T>(current_level());
+    return kernels;
+}
+
+template <class T>
+AddFn<T> &current_add_kernel() {
+    static AddFn<T> kernel = add_kernel_for<T>(current_level());
+    return kernel;
+}
+
+template <class T>
+void shift_add_impl(T *a, const T *b, size_t len, size_t shift, bool negate) {
+    assert(shift < len || len == 0);
+    const AddFn<T> add = len < 8 ? add_scalar<T> : current_add_kernel<T>();
+    add(a, b + len - shift, shift, negate);
+    add(a + shift, b, len - shift, negate);
+}
+
+template <class T>
+void shift_sum_impl(T *out, const T *a, const T *b, size_t len, size_t shift, T z) {
+    assert(shift < len || len == 0);
+    // for very short rows the vector setup and masking costs more than it saves
+    const AxpbyFn<T> axpby = len < 8 ? axpby_scalar<T> : current_kernels<T>().axpby;
+    const T keep = 1 - z;
+    // out[0, shift) reads the wrapped-around tail b[len-shift, len), out[shift, len) reads
+    // b[0, len-shift)
+    axpby(out, a, b + len - shift, shift, keep, z);
+    axpby(out + shift, a + shift, b, len - shift, keep, z);
+}
+
+} // namespace
+
+SimdLevel detect_simd_level() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SimdLevel::avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SimdLevel::avx2;
+    }
+    return SimdLevel::scalar;
+}
+
+SimdLevel simd_level() {
+    return current_level();
+}
+
+void set_simd_level_for_testing(SimdLevel level) {
+    current_level() = level;
+    current_kernels<double>() = kernels_for<double>(level);
+    current_kernels<float>() = kernels_for<float>(level);
+    current_add_kernel<int64_t>() = add_kernel_for<int64_t>(level);
+    current_add_kernel<double>() = add_kernel_for<double>(level);
+}
+
+void shift_sum(double *out, const double *a, const double *b, size_t len, size_t shift, double z) {
+    shift_sum_impl(out, a, b, len, shift, z);
+}
+
+void shift_sum(float *out, const float *a, const float *b, size_t len, size_t shift, float z) {
+    shift_sum_impl(out, a, b, len, shift, z);
+}
+
+void shift_add(int64_t *a, const int64_t *b, size_t len, size_t shift, bool negate) {
+    shift_add_impl(a, b, len, shift, negate);
+}
+
+void shift_add(double *a, const double *b, size_t len, size_t shift, bool negate) {
+    shift_add_impl(a, b, len, shift, negate);
+}
+
+void shift_sum_lanes(double *a,
+                     const double *b,
+                     size_t len,
+                     const uint32_t *shift,
+                     const double *keep,
+                     const double *w) {
+    current_kernels<double>().lanes(a, b, len, shift, keep, w);
+}
+
+void shift_sum_lanes(float *a,
+                     const float *b,
+                     size_t len,
+                     const uint32_t *shift,
+                     const float *keep,
+                     const float *w) {
+    current_kernels<float>().lanes(a, b, len, shift, keep, w);
+}
+
+} // namespace ts
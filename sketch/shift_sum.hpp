@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ts { // ts = Tensor Sketch
+
+/** The instruction sets for which vectorized tensor sketch kernels are available. */
+enum class SimdLevel { scalar, avx2, avx512 };
+
+/** Returns the best instruction set supported by the CPU we are running on. */
+SimdLevel detect_simd_level();
+
+/**
+ * Returns the instruction set used by the kernels in this file. Determined at runtime on first use,
+ * so that the same binary runs on all machines and uses the widest registers available.
+ */
+SimdLevel simd_level();
+
+/** Forces the kernels to use the given instruction set. Must be supported by the CPU. */
+void set_simd_level_for_testing(SimdLevel level);
+
+/**
+ * Computes out[i] = (1-z)*a[i] + z*b[(len+i-shift)%len] for i in [0, len). This is the inner loop
+ * of the tensor sketch recurrence. The circular shift is split into the two contiguous spans
+ * [0, shift) and [shift, len), so no modulo is needed, and each span is processed with AVX2 or
+ * AVX-512 FMA instructions, depending on what the CPU supports.
+ * #out may be the same as #a (in-place update), but must not overlap #b.
+ * @param shift the circular shift to apply to b, must be smaller than #len
+ */
+void shift_sum(double *out, const double *a, const double *b, size_t len, size_t shift, double z);
+void shift_sum(float *out, const float *a, const float *b, size_t len, size_t shift, float z);
+
+/**
+ * Computes a[i] += b[(len+i-shift)%len] for i in [0, len), or a[i] -= ... if #negate is set. This is
+ * the inner loop of the unnormalized (count) tensor sketch recurrence, which needs no
+ * multiplications and can be evaluated exactly on integers.
+ * #a must not overlap #b.
+ * @param shift the circular shift to apply to b, must be smaller than #len
+ */
+void shift_add(int64_t *a, const int64_t *b, size_t len, size_t shift, bool negate);
+void shift_add(double *a, const double *b, size_t len, size_t shift, bool negate);
+
+/** The number of sequences advanced in lockstep by #shift_sum_lanes, one per SIMD lane. */
+constexpr size_t kBatchLanes = 8;
+
+/**
+ * Lane-interleaved version of #shift_sum for sketching #kBatchLanes sequences at once. #a and #b
+ * hold #len x #kBatchLanes values, with element (i, l) at position i*kBatchLanes + l. Computes
+ * a[i][l] = keep[l]*a[i][l] + w[l]*b[(len+i-shift[l])%len][l] for all i in [0, len) and lanes l.
+ * Each lane has its own shift, so the b values are gathered rather than loaded contiguously.
+ */
+void shift_sum_lanes(double *a,
+                     const double *b,
+                     size_t len,
+                     const uint32_t *shift,
+                     const double *keep,
+                     const double *w);
+void shift_sum_lanes(float *a,
+                     const float *b,
+                     size_t len,
+                     const uint32_t *shift,
+                     const float *keep,
+                     const float *w);
+
+} // namespace ts
@@ -3,23 +3,48 @@
 #include "immintrin.h" // for AVX
 #include "nmmintrin.h" // for SSE4.2
 #include "sketch//sketch_base.hpp"
+#include "sketch/shift_sum.hpp"
+#include "util/aligned_allocator.hpp"
 #include "util/multivec.hpp"
 #include "util/timer.hpp"
 #include "util/utils.hpp"
 
 #include <cassert>
 #include <cmath>
+#include <omp.h>
 #include <random>
 
 namespace ts { // ts = Tensor Sketch
 
+/**
+ * The partial tensor sketch of a chunk of a sequence. The sketch of a concatenation of chunks can be
+ * assembled from the states of the chunks with Tensor::merge, which allows sketching a long
+ * sequence in parallel. Row (a,b) of Tp and Tm holds the partial sketch using hashes h_a...h_b, i.e.
+ * the average over all subsequences of length b-a+1 of the chunk; row (a,a-1) is the sketch of the
+ * empty subsequence.
+ */
+template <class scalar_type>
+struct TensorChunkState {
+    /** The number of characters in the chunk */
+    uint64_t length = 0;
+    AlignedVec<scalar_type> Tp;
+    AlignedVec<scalar_type> Tm;
+};
+
+/** The state of a tensor sketch over a growing sequence, see sketch/tensor_state.hpp */
+template <class seq_type, class scalar_type>
+class TensorState;
+
 /**
  * Computes tensor sketches for a given sequence as described in
  * https://www.biorxiv.org/content/10.1101/2020.11.13.381814v1
  * @tparam seq_type the type of elements in the sequences to be sketched.
+ * @tparam scalar_type the floating point type of the sketch and of the intermediate state; float
+ * halves the memory traffic and doubles the SIMD width compared to double, at the cost of a
+ * relative error in the order of 1e-6 (see test_tensor.cpp)
  */
-template <class seq_type>
-class Tensor : public SketchBase<std::vector<double>, false> {
+template <class seq_type, class scalar_type = double>
+class Tensor : public SketchBase<std::vector<scalar_type>, false> {
   public:
     // Tensor sketch output should be transformed if the command line flag is set.
     constexpr static bool transform_sketches = false;
@@ -32,16 +57,19 @@ class Tensor : public SketchBase<std::vector<double>, false> {
      * in the paper
      * @param seed the seed to initialize the random number generator used for the random hash
      * functions.
+     * @param count_mode when true, #compute uses the unnormalized recurrence, see #compute_counts
      */
     Tensor(seq_type alphabet_size,
            size_t sketch_dim,
            size_t subsequence_len,
            uint32_t seed,
-           const std::string &name = "TS")
-        : SketchBase<std::vector<double>, false>(name),
+           const std::string &name = "TS",
+           bool count_mode = false)
+        : SketchBase<std::vector<scalar_type>, false>(name),
           alphabet_size(alphabet_size),
           sketch_dim(sketch_dim),
           subsequence_len(subsequence_len),
+          count_mode(count_mode),
           rng(seed) {
         init();
     }
@@ -66,42 +94,275 @@ class Tensor : public SketchBase<std::vector<double>, false> {
      * @param seq the sequence to be sketched
      * @return an array of size #sketch_dim containing the sequence's sketch
      */
-    std::vector<double> compute(const std::vector<seq_type> &seq) {
+    std::vector<scalar_type> compute(const std::vector<seq_type> &seq) {
+        if (count_mode) {
+            return compute_counts(seq);
+        }
+        if (use_chunks(seq.size())) {
+            return compute_parallel(seq, omp_get_max_threads());
+        }
         Timer timer("tensor_sketch");
         // Tp corresponds to T+, Tm to T- in the paper; Tp[0], Tm[0] are sentinels and contain the
         // initial condition for empty strings; Tp[p], Tm[p] represent the partial sketch when
         // considering hashes h1...hp, over the prefix x1...xi. The final result is then
         // Tp[t]-Tm[t], where t is #sequence_len
-        auto Tp = new2D<double>(subsequence_len + 1, sketch_dim, 0);
-        auto Tm = new2D<double>(subsequence_len + 1, sketch_dim, 0);
+        // All the rows of Tp and Tm live in a single aligned buffer, row p of Tp starting at
+        // p*stride and row p of Tm at (t+1+p)*stride. The buffer is owned by the calling thread and
+        // reused between calls, so that sketching many sequences in parallel doesn't allocate.
+        const size_t stride = aligned_len<scalar_type>(sketch_dim);
+        static thread_local AlignedVec<scalar_type> workspace;
+        workspace.assign(2 * (subsequence_len + 1) * stride, 0);
+        scalar_type *Tp = workspace.data();
+        scalar_type *Tm = Tp + (subsequence_len + 1) * stride;
 
         // the initial condition states that the sketch for the empty string is (1,0,..)
-        Tp[0][0] = 1;
-        for (uint32_t i = 0; i < seq.size(); i++) {
-            const seq_type c = seq[i];
+        Tp[0] = 1;
+        advance(Tp, Tm, stride, seq.data(), seq.size(), 0);
+        std::vector<scalar_type> sketch(sketch_dim, 0);
+        for (uint32_t m = 0; m < sketch_dim; m++) {
+            sketch[m] = Tp[subsequence_len * stride + m] - Tm[subsequence_len * stride + m];
+        }
+
+        return sketch;
+    }
+
+    /**
+     * Computes the sketches of #seq for all the orders (subsequence lengths) 1...t in a single pass.
+     * The sketch of order p uses the hash functions h1...hp, so it is the same as the one computed
+     * by a Tensor with subsequence_len=p and the same seed.
+     * @return a t x #sketch_dim matrix, row p-1 containing the sketch of order p
+     */
+    Vec2D<scalar_type> compute_all_orders(const std::vector<seq_type> &seq) {
+        Timer timer("tensor_sketch_all_orders");
+        Vec2D<scalar_type> sketches(subsequence_len);
+        if (use_chunks(seq.size())) {
+            // the merged state contains the partial sketches for all ranges h1...hp
+            const TensorChunkState<scalar_type> state = merge_chunks(seq, omp_get_max_threads());
+            for (uint32_t p = 1; p <= subsequence_len; ++p) {
+                sketches[p - 1] = sketch(state, p);
+            }
+            return sketches;
+        }
+        const size_t stride = aligned_len<scalar_type>(sketch_dim);
+        static thread_local AlignedVec<scalar_type> workspace;
+        workspace.assign(2 * (subsequence_len + 1) * stride, 0);
+        scalar_type *Tp = workspace.data();
+        scalar_type *Tm = Tp + (subsequence_len + 1) * stride;
+        Tp[0] = 1;
+        advance(Tp, Tm, stride, seq.data(), seq.size(), 0);
+        for (uint32_t p = 1; p <= subsequence_len; ++p) {
+            sketches[p - 1].resize(sketch_dim);
+            for (uint32_t m = 0; m < sketch_dim; m++) {
+                sketches[p - 1][m] = Tp[p * stride + m] - Tm[p * stride + m];
+            }
+        }
+        return sketches;
+    }
+
+    /**
+     * Computes the same sketch as #compute using the unnormalized recurrence
+     * T[p] += s*shift(T[p-1]) of python/lib/tensor_sketch.py, which needs a single addition per
+     * element, and normalizes once at the end by binomial(n, t). T[p][m] is the signed number of
+     * subsequences of length p that hash to m, so its absolute value is at most binomial(n, p).
+     * The counts are accumulated exactly in int64 when that bound allows it, so the result doesn't
+     * depend on the instruction set or the thread count, and in double otherwise.
+     * Characters outside the alphabet are skipped and don't count towards n.
+     */
+    std::vector<scalar_type> compute_counts(const std::vector<seq_type> &seq) {
+        Timer timer("tensor_sketch_counts");
+        uint64_t n = 0;
+        for (const seq_type c : seq) {
+            n += !(c < 0 or c >= alphabet_size);
+        }
+        double max_count = 1;
+        double count = 1; // binomial(n, p)
+        for (uint32_t p = 1; p <= subsequence_len; ++p) {
+            count = count * (n - p + 1.0) / p;
+            max_count = std::max(max_count, count);
+        }
+        // count is now binomial(n, t), the number of subsequences the sketch averages over
+        if (max_count < 0x1p62) {
+            return compute_counts<int64_t>(seq, count);
+        }
+        return compute_counts<double>(seq, count);
+    }
+
+    /**
+     * Computes the sketches of a batch of sequences packed one after the other in #seqs, using the
+     * same layout as the `starts` array in python/lib/tensor_sketch_gpu.py. #kBatchLanes sequences
+     * are advanced in lockstep, one per SIMD lane, which keeps the vector units busy even when
+     * #sketch_dim is small.
+     * @param seqs the concatenation of the sequences to be sketched
+     * @param starts sequence j is seqs[starts[j]...starts[j+1]-1]; must contain n+1 elements for a
+     * batch of n sequences
+     * @return a contiguous n x #sketch_dim matrix, row j containing the sketch of sequence j
+     */
+    std::vector<scalar_type> compute_batch(const std::vector<seq_type> &seqs,
+                                           const std::vector<size_t> &starts) {
+        Timer timer("tensor_sketch_batch");
+        assert(!starts.empty() && starts.back() <= seqs.size());
+        constexpr size_t L = kBatchLanes;
+        const size_t n = starts.size() - 1;
+        std::vector<scalar_type> sketches(n * sketch_dim, 0);
+
+#pragma omp parallel for default(shared)
+        for (size_t first = 0; first < n; first += L) {
+            const size_t lanes = std::min(L, n - first);
+            size_t max_len = 0;
+            for (size_t l = 0; l < lanes; ++l) {
+                max_len = std::max(max_len, starts[first + l + 1] - starts[first + l]);
+            }
+
+            // Unlike #compute, a single signed state T=T+ - T- is kept, as in
+            // python/lib/tensor_sketch.py. T[p][m][l] is stored at (p*sketch_dim + m)*L + l, so
+            // that the L lanes of an element are contiguous.
+            const size_t row = sketch_dim * L;
+            static thread_local AlignedVec<scalar_type> workspace;
+            workspace.assign((subsequence_len + 1) * row, 0);
+            scalar_type *T = workspace.data();
+            for (size_t l = 0; l < L; ++l) {
+                T[l] = 1;
+            }
+
+            uint32_t shift[L];
+            scalar_type keep[L];
+            scalar_type w[L];
+            bool active[L];
+            seq_type chars[L];
+            for (uint32_t i = 0; i < max_len; ++i) {
+                // lanes past the end of their sequence (or the batch) keep their state
+                for (size_t l = 0; l < L; ++l) {
+                    active[l] = l < lanes && starts[first + l] + i < starts[first + l + 1];
+                    chars[l] = active[l] ? seqs[starts[first + l] + i] : 0;
+                    active[l] = active[l] && !(chars[l] < 0 or chars[l] >= alphabet_size);
+                }
+                for (uint32_t p = std::min(i + 1, (uint32_t)subsequence_len); p >= 1; --p) {
+                    const scalar_type z = p / (i + 1.0); // probability that the last index is i
+                    for (size_t l = 0; l < L; ++l) {
+                        shift[l] = active[l] ? hashes[p - 1][chars[l]] : 0;
+                        keep[l] = active[l] ? 1 - z : 1;
+                        w[l] = active[l] ? (signs[p - 1][chars[l]] ? z : -z) : 0;
+                    }
+                    shift_sum_lanes(T + p * row, T + (p - 1) * row, sketch_dim, shift, keep, w);
+                }
+            }
+
+            for (size_t l = 0; l < lanes; ++l) {
+                for (uint32_t m = 0; m < sketch_dim; ++m) {
+                    sketches[(first + l) * sketch_dim + m] = T[subsequence_len * row + m * L + l];
+                }
+            }
+        }
+        return sketches;
+    }
+
+    /**
+     * Computes the sketch of #seq by splitting it into #num_chunks chunks that are sketched in
+     * parallel and then merged. Since the hash function used for a character depends on its
+     * position in the subsequence, each chunk must keep the partial sketches for all ranges of
+     * hashes h_a...h_b, which is (t+1)/2 times more work per character than #compute.
+     * @return the same sketch as #compute, up to rounding errors
+     */
+    std::vector<scalar_type> compute_parallel(const std::vector<seq_type> &seq, size_t num_chunks) {
+        Timer timer("tensor_sketch_parallel");
+        return sketch(merge_chunks(seq, num_chunks));
+    }
+
+    /**
+     * Computes the partial sketches of seq[begin...end-1] for all ranges of hashes h_a...h_b.
+     * Characters outside the alphabet are skipped and don't count towards the length of the chunk.
+     */
+    TensorChunkState<scalar_type> compute_state(const std::vector<seq_type> &seq,
+                                           size_t begin,
+                                           size_t end) {
+        const size_t stride = aligned_len<scalar_type>(sketch_dim);
+        TensorChunkState<scalar_type> state;
+        state.Tp.assign(num_state_rows() * stride, 0);
+        state.Tm.assign(num_state_rows() * stride, 0);
+        for (uint32_t a = 1; a <= subsequence_len + 1U; ++a) {
+            state.Tp[row(a, a - 1)] = 1;
+        }
+
+        uint32_t i = 0; // the number of characters processed so far
+        for (size_t pos = begin; pos < end; ++pos) {
+            const seq_type c = seq[pos];
             if (c < 0 or c >= alphabet_size) {
                 continue;
             }
-            // must traverse in reverse order, to avoid overwriting the values of Tp and Tm before
-            // they are used in the recurrence
-            for (uint32_t p = std::min(i + 1, (uint32_t)subsequence_len); p >= 1; --p) {
-                const double z = p / (i + 1.0); // probability that the last index is i
-                const seq_type r = hashes[p - 1][c];
-                const bool s = signs[p - 1][c];
-                if (s) {
-                    this->shift_sum_inplace(Tp[p], Tp[p - 1], r, z);
-                    this->shift_sum_inplace(Tm[p], Tm[p - 1], r, z);
-                } else {
-                    this->shift_sum_inplace(Tp[p], Tm[p - 1], r, z);
-                    this->shift_sum_inplace(Tm[p], Tp[p - 1], r, z);
+            for (uint32_t a = 1; a <= subsequence_len; ++a) {
+                // traverse b in reverse order, as (a,b) is computed from (a,b-1)
+                for (uint32_t b = std::min(a + i, (uint32_t)subsequence_len); b >= a; --b) {
+                    // probability that the last index of a subsequence of length b-a+1 is i
+                    const scalar_type z = (b - a + 1) / (i + 1.0);
+                    const seq_type r = hashes[b - 1][c];
+                    scalar_type *tp = state.Tp.data() + row(a, b);
+                    scalar_type *tm = state.Tm.data() + row(a, b);
+                    if (signs[b - 1][c]) {
+                        shift_sum_inplace(tp, tp - stride, r, z);
+                        shift_sum_inplace(tm, tm - stride, r, z);
+                    } else {
+                        shift_sum_inplace(tp, tm - stride, r, z);
+                        shift_sum_inplace(tm, tp - stride, r, z);
+                    }
                 }
             }
+            i++;
         }
-        std::vector<double> sketch(sketch_dim, 0);
-        for (uint32_t m = 0; m < sketch_dim; m++) {
-            sketch[m] = Tp[subsequence_len][m] - Tm[subsequence_len][m];
+        state.length = i;
+        return state;
+    }
+
+    /**
+     * Computes the state of the concatenation of the chunks represented by #left and #right. A
+     * subsequence of length m of the concatenation consists of j characters from #left, using
+     * hashes h_a...h_{a+j-1}, and m-j characters from #right, using h_{a+j}...h_b. Summing over j
+     * the circular convolutions of the corresponding partial sketches, weighted by the fraction of
+     * subsequences that split this way, gives the partial sketch of the concatenation.
+     */
+    TensorChunkState<scalar_type> merge(const TensorChunkState<scalar_type> &left,
+                                   const TensorChunkState<scalar_type> &right) {
+        const size_t stride = aligned_len<scalar_type>(sketch_dim);
+        TensorChunkState<scalar_type> state;
+        state.length = left.length + right.length;
+        state.Tp.assign(num_state_rows() * stride, 0);
+        state.Tm.assign(num_state_rows() * stride, 0);
+        for (uint32_t a = 1; a <= subsequence_len + 1U; ++a) {
+            state.Tp[row(a, a - 1)] = 1;
         }
+        for (uint32_t a = 1; a <= subsequence_len; ++a) {
+            for (uint32_t b = a; b <= subsequence_len; ++b) {
+                scalar_type *tp = state.Tp.data() + row(a, b);
+                scalar_type *tm = state.Tm.data() + row(a, b);
+                for (uint32_t j = 0; j <= b - a + 1; ++j) {
+                    const double w = split_fraction(left.length, right.length, b - a + 1, j);
+                    if (w == 0) {
+                        continue;
+                    }
+                    const size_t l = row(a, a + j - 1);
+                    const size_t r = row(a + j, b);
+                    // the sign of a product is + iff the signs of the factors are the same
+                    convolve_add(tp, left.Tp.data() + l, right.Tp.data() + r, w);
+                    convolve_add(tp, left.Tm.data() + l, right.Tm.data() + r, w);
+                    convolve_add(tm, left.Tp.data() + l, right.Tm.data() + r, w);
+                    convolve_add(tm, left.Tm.data() + l, right.Tp.data() + r, w);
+                }
+            }
+        }
+        return state;
+    }
 
+    /** Returns the sketch of the sequence represented by #state */
+    std::vector<scalar_type> sketch(const TensorChunkState<scalar_type> &state) {
+        return sketch(state, subsequence_len);
+    }
+
+    /** Returns the sketch of order #order <= t of the sequence represented by #state */
+    std::vector<scalar_type> sketch(const TensorChunkState<scalar_type> &state, uint32_t order) {
+        std::vector<scalar_type> sketch(sketch_dim);
+        const size_t r = row(1, order);
+        for (uint32_t m = 0; m < sketch_dim; m++) {
+            sketch[m] = state.Tp[r + m] - state.Tm[r + m];
+        }
         return sketch;
     }
 
@@ -111,23 +372,192 @@ class Tensor : public SketchBase<std::vector<double>, false> {
         signs = s;
     }
 
-    static double dist(const std::vector<double> &a, const std::vector<double> &b) {
+    static double dist(const std::vector<scalar_type> &a, const std::vector<scalar_type> &b) {
         Timer timer("tensor_sketch_dist");
-        return l2_dist(a, b);
+        return l2_dist<scalar_type, double>(a, b);
     }
 
-  protected:
-    /** Computes (1-z)*a + z*b_shift */
-    void shift_sum_inplace(std::vector<double> &a,
-                           const std::vector<double> &b,
-                           seq_type shift,
-                           double z) {
+    /** Returns the distances between the sketches of each order, see #compute_all_orders */
+    static std::vector<double> dist_per_order(const Vec2D<scalar_type> &a,
+                                              const Vec2D<scalar_type> &b) {
+        Timer timer("tensor_sketch_dist");
+        assert(a.size() == b.size());
+        std::vector<double> dists(a.size());
+        for (size_t p = 0; p < a.size(); ++p) {
+            dists[p] = l2_dist<scalar_type, double>(a[p], b[p]);
+        }
+        return dists;
+    }
+
+    /**
+     * Multi-order distance between two outputs of #compute_all_orders: the sum of the distances
+     * between the sketches of each order, i.e. the distance between the concatenated sketches.
+     */
+    static double dist_all_orders(const Vec2D<scalar_type> &a, const Vec2D<scalar_type> &b) {
+        Timer timer("tensor_sketch_dist");
         assert(a.size() == b.size());
-        size_t len = a.size();
-        for (uint32_t i = 0; i < len; i++) {
-            a[i] = (1 - z) * a[i] + z * b[(len + i - shift) % len];
+        return l2_dist2D_minlen<scalar_type, double>(a, b);
+    }
+
+  protected:
+    /**
+     * Computes (1-z)*a + z*b_shift, where a and b are rows of length #sketch_dim. The element type
+     * may differ from #scalar_type, so that subclasses can keep a more precise state than the
+     * sketches they output.
+     */
+    template <class T>
+    void shift_sum_inplace(T *a, const T *b, seq_type shift, T z) const {
+        ts::shift_sum(a, a, b, sketch_dim, shift, z);
+#ifndef NDEBUG
+        for (uint32_t i = 0; i < sketch_dim; i++) {
             assert(a[i] <= 1 + 1e-5 && a[i] >= -1e-5);
         }
+#endif
+    }
+
+    friend class TensorState<seq_type, scalar_type>;
+
+    /**
+     * Advances the state (Tp, Tm) of a prefix of length #first, laid out as in #compute, by the
+     * characters chunk[0...n-1].
+     */
+    void advance(scalar_type *Tp,
+                 scalar_type *Tm,
+                 size_t stride,
+                 const seq_type *chunk,
+                 size_t n,
+                 uint64_t first) const {
+        for (size_t j = 0; j < n; j++) {
+            const seq_type c = chunk[j];
+            if (c < 0 or c >= alphabet_size) {
+                continue;
+            }
+            const uint64_t i = first + j;
+            // must traverse in reverse order, to avoid overwriting the values of Tp and Tm before
+            // they are used in the recurrence
+            for (uint32_t p = std::min(i + 1, (uint64_t)subsequence_len); p >= 1; --p) {
+                const scalar_type z = p / (i + 1.0); // probability that the last index is i
+                const seq_type r = hashes[p - 1][c];
+                const bool s = signs[p - 1][c];
+                scalar_type *tp = Tp + p * stride;
+                scalar_type *tm = Tm + p * stride;
+                if (s) {
+                    this->shift_sum_inplace(tp, tp - stride, r, z);
+                    this->shift_sum_inplace(tm, tm - stride, r, z);
+                } else {
+                    this->shift_sum_inplace(tp, tm - stride, r, z);
+                    this->shift_sum_inplace(tm, tp - stride, r, z);
+                }
+            }
+        }
+    }
+
+    /**
+     * Whether a sequence of length #len is sketched in chunks. The chunked computation does about
+     * (t+1)/2 times more work per character, so it only pays off for long sequences and if there
+     * are enough idle threads.
+     */
+    bool use_chunks(size_t len) const {
+        return len >= kMinParallelLen && !omp_in_parallel()
+                && (size_t)omp_get_max_threads() > subsequence_len;
+    }
+
+    /** Computes the states of #num_chunks chunks of #seq in parallel and merges them */
+    TensorChunkState<scalar_type> merge_chunks(const std::vector<seq_type> &seq, size_t num_chunks) {
+        num_chunks = std::max<size_t>(1, std::min(num_chunks, seq.size()));
+        std::vector<TensorChunkState<scalar_type>> states(num_chunks);
+#pragma omp parallel for default(shared)
+        for (size_t j = 0; j < num_chunks; ++j) {
+            states[j] = compute_state(seq, seq.size() * j / num_chunks,
+                                      seq.size() * (j + 1) / num_chunks);
+        }
+        TensorChunkState<scalar_type> state = std::move(states[0]);
+        for (size_t j = 1; j < num_chunks; ++j) {
+            state = merge(state, states[j]);
+        }
+        return state;
+    }
+
+    /**
+     * Runs the unnormalized recurrence with counts of type #count_type and divides the result by
+     * #num_subsequences.
+     */
+    template <class count_type>
+    std::vector<scalar_type> compute_counts(const std::vector<seq_type> &seq,
+                                            double num_subsequences) {
+        // T[p] is a single signed state, i.e. Tp[p]-Tm[p] in #compute, stored at p*stride
+        const size_t stride = aligned_len<count_type>(sketch_dim);
+        static thread_local AlignedVec<count_type> workspace;
+        workspace.assign((subsequence_len + 1) * stride, 0);
+        count_type *T = workspace.data();
+        T[0] = 1;
+        uint32_t i = 0; // the number of characters processed so far
+        for (const seq_type c : seq) {
+            if (c < 0 or c >= alphabet_size) {
+                continue;
+            }
+            for (uint32_t p = std::min(i + 1, (uint32_t)subsequence_len); p >= 1; --p) {
+                shift_add(T + p * stride, T + (p - 1) * stride, sketch_dim, hashes[p - 1][c],
+                          !signs[p - 1][c]);
+            }
+            i++;
+        }
+        std::vector<scalar_type> sketch(sketch_dim, 0);
+        if (num_subsequences >= 1) {
+            for (uint32_t m = 0; m < sketch_dim; m++) {
+                sketch[m] = T[subsequence_len * stride + m] / num_subsequences;
+            }
+        }
+        return sketch;
+    }
+
+    /** Sequences shorter than this are never split into chunks by #compute */
+    static constexpr size_t kMinParallelLen = 1 << 20;
+
+    /** The number of rows (a,b) in a #TensorChunkState, with 1<=a<=t+1 and 0<=b<=t */
+    size_t num_state_rows() const { return (subsequence_len + 2) * (subsequence_len + 1); }
+
+    /** The offset of row (a,b) in a #TensorChunkState */
+    size_t row(uint32_t a, uint32_t b) const {
+        return (a * (subsequence_len + 1) + b) * aligned_len<scalar_type>(sketch_dim);
+    }
+
+    /** Computes out += w * (u*v), where * denotes the circular convolution of rows u and v */
+    void convolve_add(scalar_type *out, const scalar_type *u, const scalar_type *v, double w) {
+        for (uint32_t s = 0; s < sketch_dim; ++s) {
+            if (u[s] == 0) {
+                continue;
+            }
+            const scalar_type c = w * u[s];
+            for (uint32_t m = s; m < sketch_dim; ++m) {
+                out[m] += c * v[m - s];
+            }
+            for (uint32_t m = 0; m < s; ++m) {
+                out[m] += c * v[sketch_dim + m - s];
+            }
+        }
+    }
+
+    /**
+     * Returns the probability that exactly j of m indices drawn without replacement from a
+     * sequence of length left+right fall into its first #left positions.
+     */
+    static double split_fraction(uint64_t left, uint64_t right, uint32_t m, uint32_t j) {
+        if (j > left || m - j > right) {
+            return 0;
+        }
+        const uint64_t n = left + right;
+        double result = 1;
+        for (uint32_t r = 0; r < j; ++r) { // binomial(m, j)
+            result = result * (m - r) / (r + 1);
+        }
+        for (uint32_t r = 0; r < j; ++r) {
+            result *= double(left - r) / (n - r);
+        }
+        for (uint32_t r = 0; r < m - j; ++r) {
+            result *= double(right - r) / (n - j - r);
+        }
+        return result;
     }
 
     /** Size of the alphabet over which sequences to be sketched are defined, e.g. 4 for DNA */
@@ -137,6 +567,9 @@ class Tensor : public SketchBase<std::vector<double>, false> {
     /** The length of the subsequences considered for sketching, denoted by t in the paper */
     uint8_t subsequence_len;
 
+    /** Whether #compute uses the unnormalized recurrence, see #compute_counts */
+    bool count_mode;
+
     /**
      * Denotes the hash functions h1,....ht:A->{1....D}, where t is #subsequence_len and D is
      * #sketch_dim
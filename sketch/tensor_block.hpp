@@ -3,13 +3,14 @@
 #include "immintrin.h" // for AVX
 #include "nmmintrin.h" // for SSE4.2
 #include "sketch//sketch_base.hpp"
+#include "sketch/shift_sum.hpp"
+#include "util/aligned_allocator.hpp"
 #include "util/multivec.hpp"
 #include "util/timer.hpp"
 #include "util/utils.hpp"
 
 #include <cassert>
 #include <cmath>
-#include <deque>
 #include <random>
 
 namespace ts { // ts = Tensor Sketch
@@ -21,9 +22,10 @@ namespace ts { // ts = Tensor Sketch
  * recurrence formula for this case is at https://go.grlab.org/tensor_block.
  * For block_size=1, the normal the #TensorBlock sketch is identical with #Tensor sketch.
  * @tparam seq_type the type of elements in the sequences to be sketched.
+ * @tparam scalar_type the floating point type of the sketch and of the intermediate state
  */
-template <class seq_type>
-class TensorBlock : public SketchBase<std::vector<double>, false> {
+template <class seq_type, class scalar_type = double>
+class TensorBlock : public SketchBase<std::vector<scalar_type>, false> {
   public:
     // Tensor sketch output should be transformed if the command line flag is set.
     constexpr static bool transform_sketches = false;
@@ -44,7 +46,7 @@ class TensorBlock : public SketchBase<std::vector<double>, false> {
                 uint8_t block_size,
                 uint32_t seed,
                 const std::string &name = "TSB")
-        : SketchBase<std::vector<double>, false>(name),
+        : SketchBase<std::vector<scalar_type>, false>(name),
           block_size(block_size),
           alphabet_size(alphabet_size),
           sketch_dim(sketch_dim),
@@ -67,6 +69,7 @@ class TensorBlock : public SketchBase<std::vector<double>, false> {
                 signs[h][c] = rand_bool(rng);
             }
         }
+        init_block_tables();
     }
 
     /**
@@ -74,7 +77,7 @@ class TensorBlock : public SketchBase<std::vector<double>, false> {
      * @param seq the sequence to be sketched
      * @return an array of size #sketch_dim containing the sequence's sketch
      */
-    std::vector<double> compute(const std::vector<seq_type> &seq) {
+    std::vector<scalar_type> compute(const std::vector<seq_type> &seq) {
         Timer timer("tensor_sketch");
         // Tp corresponds to T+, Tm to T- in the paper; Tp[0], Tm[0] are sentinels and contain the
         // initial condition for empty strings; Tp[p], Tm[p] at step i represent the partial sketch
@@ -82,63 +85,78 @@ class TensorBlock : public SketchBase<std::vector<double>, false> {
         // Tp[t]-Tm[t], where t is #sequence_len
         // since the recurrence formula references the T_[1:N-k], i.e. the element situated
         // k=block_size positions behind, we need to always keep the last block_size Tp and Tm
-        // matrices. At each iteration we create a new pair of Tp and Tm and then discard the oldest
-        // Tp/Tn pair.
-        // TODO(ddanciu): use a circular queue on top of vector instead
-        std::deque<Vec2D<double>> Tp;
-        std::deque<Vec2D<double>> Tm;
+        // matrices. They are kept in a circular buffer of block_size slots, each made of the m+1
+        // rows of Tp followed by the m+1 rows of Tm. The matrices for step i are computed in place
+        // over the ones for step i-block_size, which are the oldest in the buffer: row bc only
+        // depends on row bc of step i-1 and row bc-1 of step i-block_size, so traversing bc in
+        // reverse order reads each row of step i-block_size before it is overwritten.
 
         // The number of blocks.
-        uint32_t m = subsequence_len / block_size;
-
-        for (uint32_t i = 0; i < block_size; ++i) {
-            Tp.push_back(new2D<double>(m + 1, sketch_dim, 0));
-            Tm.push_back(new2D<double>(m + 1, sketch_dim, 0));
+        const uint32_t m = subsequence_len / block_size;
+        const size_t stride = aligned_len<scalar_type>(sketch_dim);
+        const size_t slot_size = 2 * (m + 1) * stride;
+        static thread_local AlignedVec<scalar_type> workspace;
+        workspace.assign(block_size * slot_size, 0);
+        for (uint32_t k = 0; k < block_size; ++k) {
             // the initial condition states that the sketch for the empty string is (1,0,..)
-            Tp.back()[0][0] = 1;
+            workspace[k * slot_size] = 1;
         }
+        auto Tp = [&](uint32_t slot, uint32_t bc) {
+            return workspace.data() + slot * slot_size + bc * stride;
+        };
+        auto Tm = [&](uint32_t slot, uint32_t bc) {
+            return workspace.data() + slot * slot_size + (m + 1 + bc) * stride;
+        };
 
-        // the are the "new" Tp and Tm, computed at every iteration and appended to Tp and Tm
-        auto nTp = new2D<double>(m + 1, sketch_dim, 0);
-        auto nTm = new2D<double>(m + 1, sketch_dim, 0);
+        // the code of the block seq[i-block_size+1...i], see #block_hashes
+        size_t code = 0;
+        for (uint32_t i = 0; i + 1 < block_size && i < seq.size(); i++) {
+            code = code * alphabet_size + seq[i];
+        }
+        // the slot holding the matrices for step i-block_size, which are replaced by step i
+        uint32_t oldest = 0;
         for (uint32_t i = block_size - 1; i < seq.size(); i++) {
+            const uint32_t last = (oldest + block_size - 1) % block_size; // step i-1
+            if (num_block_codes > 0) {
+                code = (code * alphabet_size + seq[i]) % num_block_codes;
+            }
             uint32_t block_count = std::min(m, (i + 1) / block_size);
             // must traverse in reverse order, to avoid overwriting the values of Tp and Tm before
             // they are used in the recurrence
             // p must be a multiple of block_size
             for (uint32_t bc = block_count; bc > 0; bc--) {
                 uint32_t p = bc * block_size;
-                double z = bc / (i + 1.0 - p + bc); // probability that the last index is i
-                seq_type r = 0;
-                bool s = true;
-                for (uint32_t j = 0; j < block_size; ++j) {
-                    r += hashes[p - j - 1][seq[i - j]];
-                    s = s == signs[p - j - 1][seq[i - j]];
+                scalar_type z = bc / (i + 1.0 - p + bc); // probability that the last index is i
+                seq_type r;
+                bool s;
+                if (num_block_codes > 0) {
+                    r = block_hashes[(bc - 1) * num_block_codes + code];
+                    s = block_signs[(bc - 1) * num_block_codes + code];
+                } else {
+                    r = 0;
+                    s = true;
+                    for (uint32_t j = 0; j < block_size; ++j) {
+                        r += hashes[p - j - 1][seq[i - j]];
+                        s = s == signs[p - j - 1][seq[i - j]];
+                    }
+                    r %= sketch_dim;
                 }
-                r %= sketch_dim;
                 if (s) {
-                    nTp[bc] = this->shift_sum(Tp.back()[bc], Tp[0][bc - 1], r, z);
-                    nTm[bc] = this->shift_sum(Tm.back()[bc], Tm[0][bc - 1], r, z);
+                    shift_sum(Tp(oldest, bc), Tp(last, bc), Tp(oldest, bc - 1), r, z);
+                    shift_sum(Tm(oldest, bc), Tm(last, bc), Tm(oldest, bc - 1), r, z);
                 } else {
-                    nTp[bc] = this->shift_sum(Tp.back()[bc], Tm[0][bc - 1], r, z);
-                    nTm[bc] = this->shift_sum(Tm.back()[bc], Tp[0][bc - 1], r, z);
+                    shift_sum(Tp(oldest, bc), Tp(last, bc), Tm(oldest, bc - 1), r, z);
+                    shift_sum(Tm(oldest, bc), Tm(last, bc), Tp(oldest, bc - 1), r, z);
                 }
             }
-            nTp[0][0] = 1;
-            Tp.push_back(std::move(nTp));
-            Tm.push_back(std::move(nTm));
-            nTp = std::move(Tp.front());
-            nTm = std::move(Tm.front());
-            for (uint32_t j = 0; j < m + 1; ++j) {
-                std::fill(nTp[j].begin(), nTp[j].end(), 0);
-                std::fill(nTm[j].begin(), nTm[j].end(), 0);
-            }
-            Tp.pop_front();
-            Tm.pop_front();
+            // rows above block_count are 0 for both steps i-block_size and i, and row 0 is the
+            // initial condition for all steps, so they don't need to be updated
+            oldest = (oldest + 1) % block_size;
         }
-        std::vector<double> sketch(sketch_dim, 0);
+        const uint32_t last = (oldest + block_size - 1) % block_size;
+        std::vector<scalar_type> sketch(sketch_dim, 0);
         for (uint32_t l = 0; l < sketch_dim; l++) {
-            sketch[l] = Tp.back()[m][l] - Tm.back()[m][l];
+            sketch[l] = Tp(last, m)[l] - Tm(last, m)[l];
         }
 
         return sketch;
@@ -148,27 +166,66 @@ class TensorBlock : public SketchBase<std::vector<double>, false> {
     void set_hashes_for_testing(const Vec2D<seq_type> &h, const Vec2D<bool> &s) {
         hashes = h;
         signs = s;
+        init_block_tables();
     }
 
-    static double dist(const std::vector<double> &a, const std::vector<double> &b) {
+    static double dist(const std::vector<scalar_type> &a, const std::vector<scalar_type> &b) {
         Timer timer("tensor_sketch_dist");
-        return l2_dist(a, b);
+        return l2_dist<scalar_type, double>(a, b);
     }
 
   protected:
-    /** Computes (1-z)*a + z*b_shift */
-    inline std::vector<double> shift_sum(const std::vector<double> &a,
-                                         const std::vector<double> &b,
-                                         seq_type shift,
-                                         double z) {
-        assert(a.size() == b.size());
-        size_t len = a.size();
-        std::vector<double> result(a.size());
-        for (uint32_t i = 0; i < a.size(); i++) {
-            result[i] = (1 - z) * a[i] + z * b[(len + i - shift) % len];
+    /** Blocks are only tabulated if there are at most this many distinct ones */
+    static constexpr size_t kMaxBlockCodes = 1 << 12;
+
+    /**
+     * Fills #block_hashes and #block_signs if there are at most #kMaxBlockCodes distinct blocks,
+     * otherwise sets #num_block_codes to 0.
+     */
+    void init_block_tables() {
+        num_block_codes = 1;
+        for (uint32_t j = 0; j < block_size && num_block_codes <= kMaxBlockCodes; ++j) {
+            num_block_codes *= alphabet_size;
+        }
+        if (num_block_codes > kMaxBlockCodes) {
+            num_block_codes = 0;
+            block_hashes.clear();
+            block_signs.clear();
+            return;
+        }
+        const uint32_t m = subsequence_len / block_size;
+        block_hashes.resize(m * num_block_codes);
+        block_signs.resize(m * num_block_codes);
+        for (uint32_t bc = 1; bc <= m; ++bc) {
+            const uint32_t p = bc * block_size;
+            for (size_t code = 0; code < num_block_codes; ++code) {
+                // the j-th digit of code is the character at position i-j of the block ending at i
+                seq_type r = 0;
+                bool s = true;
+                size_t rest = code;
+                for (uint32_t j = 0; j < block_size; ++j, rest /= alphabet_size) {
+                    const seq_type c = rest % alphabet_size;
+                    r += hashes[p - j - 1][c];
+                    s = s == signs[p - j - 1][c];
+                }
+                block_hashes[(bc - 1) * num_block_codes + code] = r % sketch_dim;
+                block_signs[(bc - 1) * num_block_codes + code] = s;
+            }
+        }
+    }
+
+    /** Computes (1-z)*a + z*b_shift into #result, where all arguments are rows of #sketch_dim */
+    void shift_sum(scalar_type *result,
+                   const scalar_type *a,
+                   const scalar_type *b,
+                   seq_type shift,
+                   scalar_type z) const {
+        ts::shift_sum(result, a, b, sketch_dim, shift, z);
+#ifndef NDEBUG
+        for (uint32_t i = 0; i < sketch_dim; i++) {
             assert(result[i] <= 1 + 1e-5 && result[i] >= -1e-5);
         }
-        return result;
+#endif
     }
 
     /** The size of the block each subsequence is made of. Must be a divisor of #subsequence_len.
@@ -191,6 +248,21 @@ class TensorBlock : public SketchBase<std::vector<double>, false> {
     /** The sign functions s1...st:A->{-1,1} */
     Vec2D<bool> signs;
 
+    /**
+     * The number alphabet_size^block_size of distinct blocks if they are tabulated, 0 otherwise.
+     * A block x_{i-block_size+1}...x_i has the code sum_j x_{i-j}*alphabet_size^j, which is
+     * updated in O(1) for each new character.
+     */
+    size_t num_block_codes = 0;
+    /**
+     * block_hashes[(bc-1)*num_block_codes + code] is the combined hash r used when the block with
+     * the given code is the bc-th block of a subsequence, i.e. it uses the hashes
+     * h_{(bc-1)*block_size+1}...h_{bc*block_size}
+     */
+    std::vector<seq_type> block_hashes;
+    /** The combined signs s for the same blocks as #block_hashes */
+    std::vector<uint8_t> block_signs;
+
     std::mt19937 rng;
 };
 
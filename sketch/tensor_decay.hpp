@@ -0,0 +1,134 @@
+#pragma once
+
+#include "sketch/tensor.hpp"
+#include "util/aligned_allocator.hpp"
+#include "util/multivec.hpp"
+#include "util/timer.hpp"
+#include "util/utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace ts { // ts = Tensor Sketch
+
+/**
+ * Computes sliding tensor sketches in which older characters fade out geometrically instead of
+ * leaving the window after #win_len steps. For the first #win_len characters the recurrence is the
+ * one of Tensor, i.e. the sketch of a prefix is the uniform average over its subsequences.
+ * Afterwards the probability z=p/(i+1) is frozen at p/(#win_len+1), so the state is an exponential
+ * moving average: each new character multiplies the weight of the older subsequences of length p
+ * by 1-p/(#win_len+1).
+ * Compared to TensorSlide, there is no removal pass and the sketches of the sub-ranges h_p...h_q of
+ * the hash functions are not needed, so each character costs O(t*D) instead of O(t^2*D), and the
+ * characters that left the window don't have to be kept. This allows sketching a stream, e.g.
+ * stdin, in a single pass.
+ * @tparam seq_type the type of elements in the sequences to be sketched.
+ * @tparam scalar_type the floating point type of the sketches and of the intermediate state
+ */
+template <class seq_type, class scalar_type = double>
+class TensorDecay : public Tensor<seq_type, scalar_type> {
+  public:
+    using sketch_type = Vec2D<scalar_type>;
+
+    /**
+     * @param alphabet_size the number of elements in the alphabet S over which sequences are
+     * defined (e.g. 4 for DNA)
+     * @param sketch_dim the dimension of the embedded (sketched) space, denoted by D in the paper
+     * @param tup_len the length of the subsequences considered for sketching, denoted by t
+     * in the paper
+     * @param win_len the effective window length: after #win_len more characters, the weight of a
+     * subsequence has decayed by a factor of at least 1/e
+     * @param stride sliding sketches are computed every stride characters
+     * @param seed the seed to initialize the random number generator used for the random hash
+     * functions.
+     * @param name the name of the algorithm in the output
+     */
+    TensorDecay(seq_type alphabet_size,
+                size_t sketch_dim,
+                size_t tup_len,
+                size_t win_len,
+                size_t stride,
+                uint32_t seed,
+                const std::string &name = "TSD")
+        : Tensor<seq_type, scalar_type>(alphabet_size, sketch_dim, tup_len, seed, name),
+          win_len(win_len),
+          stride(stride) {
+        assert(stride > 0 && "Stride must be positive");
+        assert(tup_len <= win_len && "Tuple length (t) cannot be larger than the window length");
+    }
+
+    /**
+     * Computes decayed sliding sketches for the given sequence, one every #stride characters.
+     * @return seq.size()/stride sketches of size #sketch_dim
+     */
+    Vec2D<scalar_type> compute(const std::vector<seq_type> &seq) {
+        Vec2D<scalar_type> sketches;
+        sketches.reserve(seq.size() / stride);
+        compute(seq.begin(), seq.end(), [&](size_t, const std::vector<scalar_type> &sketch) {
+            sketches.push_back(sketch);
+        });
+        return sketches;
+    }
+
+    /**
+     * Computes the same sketches as #compute for the characters in [begin, end), reading each
+     * character exactly once, so any input iterator can be used, e.g. an std::istreambuf_iterator.
+     * @param sink called as sink(index, sketch) for each sketch, where index is the position of the
+     * sketch in the output of #compute. The vector passed as sketch is reused for the following
+     * sketches, so it must be copied if needed after #sink returns.
+     */
+    template <class InputIt, class Sink>
+    void compute(InputIt begin, InputIt end, Sink &&sink) const {
+        Timer timer("tensor_decay_sketch");
+        const uint32_t tup_len = this->subsequence_len;
+        // Tp and Tm have the same meaning and layout as in Tensor::compute
+        const size_t dim_stride = aligned_len<scalar_type>(this->sketch_dim);
+        static thread_local AlignedVec<scalar_type> workspace;
+        workspace.assign(2 * (tup_len + 1) * dim_stride, 0);
+        scalar_type *Tp = workspace.data();
+        scalar_type *Tm = Tp + (tup_len + 1) * dim_stride;
+        Tp[0] = 1;
+        std::vector<scalar_type> sketch(this->sketch_dim);
+
+        uint64_t i = 0;
+        for (; begin != end; ++begin, ++i) {
+            const seq_type c = *begin;
+            if (c >= 0 && c < this->alphabet_size) {
+                // the number of characters the average is taken over
+                const scalar_type len = std::min<uint64_t>(i, win_len) + 1;
+                for (uint32_t p = std::min<uint64_t>(i + 1, tup_len); p >= 1; --p) {
+                    const scalar_type z = p / len;
+                    const seq_type r = this->hashes[p - 1][c];
+                    scalar_type *tp = Tp + p * dim_stride;
+                    scalar_type *tm = Tm + p * dim_stride;
+                    if (this->signs[p - 1][c]) {
+                        this->shift_sum_inplace(tp, tp - dim_stride, r, z);
+                        this->shift_sum_inplace(tm, tm - dim_stride, r, z);
+                    } else {
+                        this->shift_sum_inplace(tp, tm - dim_stride, r, z);
+                        this->shift_sum_inplace(tm, tp - dim_stride, r, z);
+                    }
+                }
+            }
+            if ((i + 1) % stride == 0) { // output a sketch every stride times
+                for (uint32_t m = 0; m < sketch.size(); ++m) {
+                    sketch[m] = Tp[tup_len * dim_stride + m] - Tm[tup_len * dim_stride + m];
+                }
+                sink((i + 1) / stride - 1, sketch);
+            }
+        }
+    }
+
+    double dist(const Vec2D<scalar_type> &a, const Vec2D<scalar_type> &b) {
+        Timer timer("tensor_decay_sketch_dist");
+        return l2_dist2D_minlen<scalar_type, double>(a, b);
+    }
+
+  private:
+    uint32_t win_len;
+    uint32_t stride;
+};
+
+} // namespace ts
@@ -4,6 +4,7 @@
 #include "nmmintrin.h" // for SSE4.2
 #include "sequence/alphabets.hpp"
 #include "sketch//sketch_base.hpp"
+#include "sketch/shift_sum.hpp"
 #include "util/multivec.hpp"
 #include "util/timer.hpp"
 #include "util/utils.hpp"
@@ -11,8 +12,11 @@
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include <numeric>
 #include <random>
 
+#include <omp.h>
+
 namespace ts { // ts = Tensor Sketch
 
 /**
@@ -47,10 +51,77 @@ class TensorEmbedding : public SketchBase<std::vector<double>, false> {
      * @return an array of size alphabet_size^t containing the sequence's sketch
      */
     std::vector<double> compute(const std::vector<seq_type> &seq) {
+        if (use_chunks(seq.size())) {
+            return compute_parallel(seq, omp_get_max_threads());
+        }
+        int32_t length;
+        Vec2D<double> ts = count(seq.data(), seq.size(), &length);
+        return finalize(std::move(ts), length);
+    }
+
+    /**
+     * Computes the sketch of #seq by splitting it into #num_chunks chunks whose tensors are
+     * computed in parallel and then joined: a subsequence of the concatenation of two chunks is
+     * the concatenation of a subsequence of each, so the counts of the tuples of length l+r are
+     * the sum of the outer products of the counts of length l of the first chunk and of length r
+     * of the second one.
+     * @return the same sketch as #compute, up to rounding errors once the counts exceed 2^53
+     */
+    std::vector<double> compute_parallel(const std::vector<seq_type> &seq, size_t num_chunks) {
+        num_chunks = std::max<size_t>(1, std::min(num_chunks, seq.size()));
+        std::vector<Vec2D<double>> chunks(num_chunks);
+        std::vector<int32_t> lengths(num_chunks, 0);
+#pragma omp parallel for default(shared)
+        for (size_t k = 0; k < num_chunks; ++k) {
+            const size_t begin = k * seq.size() / num_chunks;
+            const size_t end = (k + 1) * seq.size() / num_chunks;
+            chunks[k] = count(seq.data() + begin, end - begin, &lengths[k]);
+        }
+        Vec2D<double> ts = std::move(chunks[0]);
+        for (size_t k = 1; k < num_chunks; ++k) {
+            ts = join(ts, chunks[k]);
+        }
+        return finalize(std::move(ts), std::accumulate(lengths.begin(), lengths.end(), 0));
+    }
+
+    static double dist(const std::vector<double> &a, const std::vector<double> &b) {
+        Timer timer("full_tensor_dist");
+        return l2_dist(a, b);
+    }
+
+  protected:
+    /**
+     * Levels with at least this many entries are updated by the runtime-dispatched SIMD kernel of
+     * shift_sum.hpp, smaller ones by an inline loop, as the kernel's call overhead dominates there
+     */
+    static constexpr size_t kMinKernelLen = 64;
+
+    /** Sequences shorter than this are never split into chunks by #compute */
+    static constexpr size_t kMinParallelLen = 1 << 16;
+
+    /**
+     * Whether #compute splits a sequence of length #len into chunks. Joining two chunks costs
+     * about as much as t*alphabet_size characters, so the chunks must be much longer than that.
+     */
+    bool use_chunks(size_t len) const {
+        const size_t num_threads = omp_get_max_threads();
+        return len >= kMinParallelLen && !omp_in_parallel() && num_threads > 1;
+    }
+
+    /**
+     * Computes the counts of the subsequences of all lengths 0...t of seq[0...n-1].
+     * The tuple x_1...x_i is stored at index sum_k x_k*alphabet_size^(k-1) of level i, i.e. the
+     * last character is the most significant digit, so that the tuples ending with s are the
+     * contiguous block [s*alphabet_size^(i-1), (s+1)*alphabet_size^(i-1)) of level i. Appending a
+     * character s then adds all of level i-1 to one block of level i, a contiguous vectorized
+     * update instead of the strided scatter over the standard order.
+     * @param[out] length the number of characters of seq[0...n-1] in the alphabet
+     */
+    Vec2D<double> count(const seq_type *seq, size_t n, int32_t *length) const {
         // ts[i] contains the counts for subsequences of length i.
         Vec2D<double> ts(t + 1);
         {
-            uint32_t num_tmers = 1;
+            size_t num_tmers = 1;
             for (auto &t : ts) {
                 t.resize(num_tmers);
                 num_tmers *= alphabet_size;
@@ -61,18 +132,84 @@ class TensorEmbedding : public SketchBase<std::vector<double>, false> {
         ts[0][0] = 1;
 
         // The number of successfully read nucleotides.
-        int32_t length = 0;
-        for (auto s : seq) {
+        *length = 0;
+        for (size_t k = 0; k < n; ++k) {
+            const seq_type s = seq[k];
             // TODO(ragnar): Figure out a nice way to deal with uncertain reads.
             if (s < 0 || s >= alphabet_size)
                 continue;
-            length += 1;
+            *length += 1;
             for (int32_t i = static_cast<int32_t>(t) - 1; i >= 0; --i) {
+                const double *level = ts[i].data();
+                double *next = ts[i + 1].data() + s * ts[i].size();
+                if (ts[i].size() >= kMinKernelLen) {
+                    ts::shift_add(next, level, ts[i].size(), 0, false);
+                    continue;
+                }
                 for (size_t j = 0; j < ts[i].size(); ++j) {
-                    ts[i + 1][alphabet_size * j + s] += ts[i][j];
+                    next[j] += level[j];
                 }
             }
         }
+        return ts;
+    }
+
+    /**
+     * Returns the counts of #count for the concatenation of the sequences whose counts are
+     * #left and #right (_join in python/lib/tensor_embedding.py).
+     */
+    Vec2D<double> join(const Vec2D<double> &left, const Vec2D<double> &right) const {
+        Vec2D<double> ts(t + 1);
+        for (uint32_t i = 0; i <= t; ++i) {
+            ts[i].resize(left[i].size(), 0);
+        }
+        for (uint32_t r = 0; r <= t; ++r) {
+            for (uint32_t l = 0; l + r <= t; ++l) {
+                // the tuple x (from left) followed by y (from right) is at index
+                // y*alphabet_size^l + x, since the last character is the most significant
+                for (size_t y = 0; y < right[r].size(); ++y) {
+                    double *out = ts[l + r].data() + y * left[l].size();
+                    const double count = right[r][y];
+                    if (count == 0) {
+                        continue;
+                    }
+                    for (size_t x = 0; x < left[l].size(); ++x) {
+                        out[x] += count * left[l][x];
+                    }
+                }
+            }
+        }
+        return ts;
+    }
+
+    /**
+     * Returns the counts of the tuples of length t from #ts, converted to the standard order in
+     * which the first character is the most significant digit, and normalized if #normalize is
+     * set.
+     * @param length the number of characters in the sequence
+     */
+    std::vector<double> finalize(Vec2D<double> ts, int32_t length) const {
+        const std::vector<double> &counts = ts.back();
+        std::vector<double> result(counts.size());
+        // digits[k] is x_{k+1} and has the weight alphabet_size^(t-1-k) in the standard order
+        std::vector<uint32_t> digits(t, 0);
+        std::vector<size_t> weights(t, 1);
+        for (int32_t k = static_cast<int32_t>(t) - 2; k >= 0; --k) {
+            weights[k] = weights[k + 1] * alphabet_size;
+        }
+        size_t index = 0; // the standard index of the tuple at position j of counts
+        for (size_t j = 0; j < counts.size(); ++j) {
+            result[index] = counts[j];
+            // increment x_1...x_t, x_1 being the least significant digit
+            for (uint32_t k = 0; k < t; ++k) {
+                if (++digits[k] < alphabet_size) {
+                    index += weights[k];
+                    break;
+                }
+                digits[k] = 0;
+                index -= (alphabet_size - 1) * weights[k];
+            }
+        }
 
         if (normalize) {
             double nchooset = 1;
@@ -80,20 +217,14 @@ class TensorEmbedding : public SketchBase<std::vector<double>, false> {
                 nchooset = nchooset * (length - i) / (i + 1);
             }
 
-            for (auto &c : ts.back()) {
+            for (auto &c : result) {
                 c /= nchooset;
             }
         }
 
-        return std::move(ts.back());
+        return result;
     }
 
-    static double dist(const std::vector<double> &a, const std::vector<double> &b) {
-        Timer timer("full_tensor_dist");
-        return l2_dist(a, b);
-    }
-
-  protected:
     /** Size of the alphabet over which sequences to be sketched are defined, e.g. 4 for DNA. */
     const seq_type alphabet_size;
 
@@ -0,0 +1,227 @@
+#pragma once
+
+#include "sketch/sketch_base.hpp"
+#include "util/timer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ts { // ts = Tensor Sketch
+
+/** A sparse vector, as (index, value) pairs sorted by index, without zero values */
+using SparseVec = std::vector<std::pair<uint64_t, double>>;
+
+/**
+ * Computes the same tensor of subsequence counts as TensorEmbedding, but stores only the tuples
+ * that occur in the sequence. The number of distinct tuples of length t in a sequence of length n
+ * is at most min(alphabet_size^t, C(n,t)), which for large alphabets (e.g. proteins) and long
+ * tuples is much smaller than the alphabet_size^t entries of the dense tensor. The counts of each
+ * tuple length are kept as a sorted sparse vector, which is replaced by a dense vector once that is
+ * not much larger.
+ * @tparam seq_type the type of elements in the sequences to be sketched.
+ */
+template <class seq_type>
+class TensorEmbeddingSparse : public SketchBase<SparseVec, false> {
+  public:
+    /**
+     * @param alphabet_size the number of elements in the alphabet S over which sequences are
+     * defined (e.g. 4 for DNA)
+     * @param t the length of the subsequences that are counted; alphabet_size^t must fit in 64 bits
+     * @param normalize when true the counts will be normalized to relative frequencies with sum 1.
+     */
+    TensorEmbeddingSparse(seq_type alphabet_size,
+                          uint32_t t,
+                          const std::string &name = "TensorSparse",
+                          bool normalize = true)
+        : SketchBase<SparseVec, false>(name),
+          alphabet_size(alphabet_size),
+          t(t),
+          normalize(normalize) {
+        assert(t * std::log2((double)alphabet_size) < 64 && "alphabet_size^t must fit in 64 bits");
+    }
+
+    void init() {}
+
+    /**
+     * Computes the embedding of the given sequence.
+     * @param seq the sequence to be embedded
+     * @return the non-zero entries of the tensor computed by TensorEmbedding::compute, where the
+     * tuple x_1...x_t has the index sum_i x_i*alphabet_size^(t-i). If #seq has fewer than t
+     * characters in the alphabet, there are no tuples and the result is empty (while the
+     * normalized dense tensor is 0/0).
+     */
+    SparseVec compute(const std::vector<seq_type> &seq) {
+        Timer timer("full_tensor_sparse");
+        // levels[i] contains the counts for subsequences of length i
+        std::vector<Level> levels(t + 1);
+        levels[0].dense = { 1 }; // the base case is the one empty sequence
+        uint64_t num_tmers = 1;
+        for (uint32_t i = 1; i <= t; ++i) {
+            num_tmers *= alphabet_size;
+            levels[i].num_tmers = num_tmers;
+            if (num_tmers <= kMinSparseSize) {
+                levels[i].dense.resize(num_tmers);
+            }
+        }
+
+        // The number of successfully read nucleotides.
+        int32_t length = 0;
+        // buffers for merging the tuples extended by the new character into a sparse level
+        std::vector<uint64_t> merged_indices;
+        std::vector<double> merged_counts;
+        for (auto s : seq) {
+            if (s < 0 || s >= alphabet_size)
+                continue;
+            length += 1;
+            // must traverse in reverse order, so that the tuples ending with s are not extended
+            // again by s
+            for (int32_t i = static_cast<int32_t>(t) - 1; i >= 0; --i) {
+                const Level &level = levels[i];
+                Level &next = levels[i + 1];
+                if (!next.dense.empty()) {
+                    if (!level.dense.empty()) { // the loop of TensorEmbedding::compute
+                        for (size_t j = 0; j < level.dense.size(); ++j) {
+                            next.dense[alphabet_size * j + s] += level.dense[j];
+                        }
+                    } else {
+                        level.for_each([&](uint64_t j, double count) {
+                            next.dense[alphabet_size * j + s] += count;
+                        });
+                    }
+                    continue;
+                }
+                // j -> alphabet_size*j+s is increasing, so the extended tuples are sorted and can
+                // be merged with the ones of #next
+                merged_indices.clear();
+                merged_counts.clear();
+                size_t k = 0;
+                level.for_each([&](uint64_t j, double count) {
+                    const uint64_t index = alphabet_size * j + s;
+                    for (; k < next.indices.size() && next.indices[k] < index; ++k) {
+                        merged_indices.push_back(next.indices[k]);
+                        merged_counts.push_back(next.counts[k]);
+                    }
+                    merged_indices.push_back(index);
+                    if (k < next.indices.size() && next.indices[k] == index) {
+                        merged_counts.push_back(next.counts[k++] + count);
+                    } else {
+                        merged_counts.push_back(count);
+                    }
+                });
+                merged_indices.insert(merged_indices.end(), next.indices.begin() + k,
+                                      next.indices.end());
+                merged_counts.insert(merged_counts.end(), next.counts.begin() + k,
+                                     next.counts.end());
+                std::swap(next.indices, merged_indices);
+                std::swap(next.counts, merged_counts);
+                next.maybe_densify();
+            }
+        }
+
+        SparseVec result;
+        levels[t].for_each([&](uint64_t j, double count) { result.emplace_back(j, count); });
+
+        if (normalize) {
+            double nchooset = 1;
+            for (uint32_t i = 0; i < t; ++i) {
+                nchooset = nchooset * (length - i) / (i + 1);
+            }
+            for (auto &entry : result) {
+                entry.second /= nchooset;
+            }
+        }
+        return result;
+    }
+
+    /** Returns the same (squared) distance as TensorEmbedding::dist on the dense tensors */
+    static double dist(const SparseVec &a, const SparseVec &b) {
+        Timer timer("full_tensor_sparse_dist");
+        double res = 0;
+        auto add = [&res](double el) { res += el * el; };
+        size_t i = 0, j = 0;
+        while (i < a.size() && j < b.size()) {
+            if (a[i].first < b[j].first) {
+                add(std::abs(a[i++].second));
+            } else if (a[i].first > b[j].first) {
+                add(std::abs(b[j++].second));
+            } else {
+                add(std::abs(a[i++].second - b[j++].second));
+            }
+        }
+        for (; i < a.size(); ++i) {
+            add(std::abs(a[i].second));
+        }
+        for (; j < b.size(); ++j) {
+            add(std::abs(b[j].second));
+        }
+        return res;
+    }
+
+  private:
+    /**
+     * A level is converted to dense once it has at least 1/kDenseRatio of the alphabet_size^i
+     * possible tuples, at which point merging into the sparse level costs about as much as
+     * traversing the dense one.
+     */
+    static constexpr uint64_t kDenseRatio = 8;
+    /** Levels with at most this many entries are always dense */
+    static constexpr uint64_t kMinSparseSize = 1 << 12;
+    /** Levels with more entries than this are never converted to dense, to bound the memory */
+    static constexpr uint64_t kMaxDenseSize = 1 << 22;
+
+    /** The counts of the tuples of a given length, either in #indices and #counts or in #dense */
+    struct Level {
+        /** The number alphabet_size^i of possible tuples */
+        uint64_t num_tmers = 1;
+        /** The tuples with non-zero count, sorted increasingly, if #dense is empty */
+        std::vector<uint64_t> indices;
+        /** counts[k] is the count of the tuple indices[k] */
+        std::vector<double> counts;
+        /** The counts of all tuples if not empty, in which case #indices and #counts are empty */
+        std::vector<double> dense;
+
+        /** Calls f(index, count) for each tuple with non-zero count, in increasing order */
+        template <class F>
+        void for_each(const F &f) const {
+            if (dense.empty()) {
+                for (size_t k = 0; k < indices.size(); ++k) {
+                    f(indices[k], counts[k]);
+                }
+            } else {
+                for (uint64_t index = 0; index < dense.size(); ++index) {
+                    if (dense[index] != 0) {
+                        f(index, dense[index]);
+                    }
+                }
+            }
+        }
+
+        void maybe_densify() {
+            if (!dense.empty() || num_tmers > kMaxDenseSize
+                || indices.size() * kDenseRatio < num_tmers) {
+                return;
+            }
+            dense.resize(num_tmers);
+            for (size_t k = 0; k < indices.size(); ++k) {
+                dense[indices[k]] = counts[k];
+            }
+            indices = {};
+            counts = {};
+        }
+    };
+
+    /** Size of the alphabet over which sequences to be sketched are defined, e.g. 4 for DNA. */
+    const seq_type alphabet_size;
+
+    /** The length of the subsequences considered for sketching. */
+    const uint32_t t;
+
+    /** Whether to normalize the counts to relative frequencies with sum 1. */
+    const bool normalize;
+};
+
+} // namespace ts
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "sketch/tensor.hpp"
+
+#include <algorithm>
+
+namespace ts { // ts = Tensor Sketch
+
+/**
+ * Tensor sketch with the tuple length and the sketch dimension fixed at compile time. This lets
+ * the compiler unroll the loop over the tuple positions and keep the whole state on the stack, and,
+ * for short rows, inline the shift-sum with a known trip count instead of calling the runtime
+ * dispatched kernel. Computes exactly the same sketches as Tensor for the same seed.
+ * @tparam seq_type the type of elements in the sequences to be sketched.
+ * @tparam kTupleLen the length of the subsequences considered for sketching (t)
+ * @tparam kSketchDim the dimension of the embedded space (D)
+ */
+template <class seq_type, uint32_t kTupleLen, uint32_t kSketchDim, class scalar_type = double>
+class TensorFixed : public Tensor<seq_type, scalar_type> {
+  public:
+    /**
+     * @param alphabet_size the number of elements in the alphabet S over which sequences are
+     * defined (e.g. 4 for DNA)
+     * @param seed the seed to initialize the random number generator used for the random hash
+     * functions.
+     */
+    TensorFixed(seq_type alphabet_size, uint32_t seed, const std::string &name = "TS")
+        : Tensor<seq_type, scalar_type>(alphabet_size, kSketchDim, kTupleLen, seed, name) {}
+
+    /**
+     * Computes the sketch of the given sequence.
+     * @param seq the sequence to be sketched
+     * @return an array of size #kSketchDim containing the sequence's sketch
+     */
+    std::vector<scalar_type> compute(const std::vector<seq_type> &seq) {
+        if (seq.size() >= this->kMinParallelLen) {
+            return Tensor<seq_type, scalar_type>::compute(seq);
+        }
+        Timer timer("tensor_sketch");
+        // same recurrence as Tensor::compute, see there for the meaning of Tp and Tm
+        alignas(64) scalar_type Tp[kTupleLen + 1][kSketchDim] = {};
+        alignas(64) scalar_type Tm[kTupleLen + 1][kSketchDim] = {};
+        Tp[0][0] = 1;
+        uint32_t i = 0;
+        // the first t-1 characters only update a prefix of the rows
+        for (; i < seq.size() && i + 1 < kTupleLen; ++i) {
+            update(Tp, Tm, seq[i], i, i + 1);
+        }
+        // from here on all the rows are updated, and the loop over p has a constant trip count
+        for (; i < seq.size(); ++i) {
+            update(Tp, Tm, seq[i], i, kTupleLen);
+        }
+
+        std::vector<scalar_type> sketch(kSketchDim);
+        for (uint32_t m = 0; m < kSketchDim; m++) {
+            sketch[m] = Tp[kTupleLen][m] - Tm[kTupleLen][m];
+        }
+        return sketch;
+    }
+
+  private:
+    /** Rows up to this size are updated inline, longer ones with the vectorized ts::shift_sum */
+    static constexpr bool kInlineRows = kSketchDim * sizeof(scalar_type) <= 128;
+
+    /** Advances rows 1...max_p of the state by character #c at position #i */
+    inline void update(scalar_type (&Tp)[kTupleLen + 1][kSketchDim],
+                       scalar_type (&Tm)[kTupleLen + 1][kSketchDim],
+                       seq_type c,
+                       uint32_t i,
+                       uint32_t max_p) {
+        if (c < 0 or c >= this->alphabet_size) {
+            return;
+        }
+        for (uint32_t p = max_p; p >= 1; --p) {
+            const scalar_type z = p / (i + 1.0); // probability that the last index is i
+            const seq_type r = this->hashes[p - 1][c];
+            if (this->signs[p - 1][c]) {
+                shift_sum_fixed(Tp[p], Tp[p - 1], r, z);
+                shift_sum_fixed(Tm[p], Tm[p - 1], r, z);
+            } else {
+                shift_sum_fixed(Tp[p], Tm[p - 1], r, z);
+                shift_sum_fixed(Tm[p], Tp[p - 1], r, z);
+            }
+        }
+    }
+
+    /** Computes (1-z)*a + z*b_shift for rows of length #kSketchDim */
+    static inline void
+    shift_sum_fixed(scalar_type *a, const scalar_type *b, uint32_t shift, scalar_type z) {
+        if constexpr (kInlineRows) {
+            for (uint32_t m = 0; m < shift; ++m) {
+                a[m] = (1 - z) * a[m] + z * b[kSketchDim - shift + m];
+            }
+            for (uint32_t m = shift; m < kSketchDim; ++m) {
+                a[m] = (1 - z) * a[m] + z * b[m - shift];
+            }
+        } else {
+            ts::shift_sum(a, a, b, kSketchDim, shift, z);
+        }
+    }
+};
+
+} // namespace ts
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "sketch/shift_sum.hpp"
+#include "sketch/sketch_base.hpp"
+#include "util/aligned_allocator.hpp"
+#include "util/multivec.hpp"
+#include "util/timer.hpp"
+#include "util/utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <random>
+
+namespace ts { // ts = Tensor Sketch
+
+/**
+ * Computes R independent tensor sketches of a sequence in a single pass, each using its own hash and
+ * sign functions. This is equivalent to running R Tensor sketchers with different seeds, but the
+ * sequence is traversed only once, and the character loads, the loop over the tuple positions and
+ * the probabilities z are shared between the repetitions. The distance between two sketches is
+ * obtained by reducing the R per-repetition distances with the median or the mean, which is more
+ * stable than the distance of a single sketch.
+ * @tparam seq_type the type of elements in the sequences to be sketched.
+ * @tparam scalar_type the floating point type of the sketch and of the intermediate state
+ */
+template <class seq_type, class scalar_type = double>
+class TensorMulti : public SketchBase<Vec2D<scalar_type>, false> {
+  public:
+    /** How the distances of the individual repetitions are combined by #dist */
+    enum class Reducer { median, mean };
+
+    /**
+     * @param alphabet_size the number of elements in the alphabet S over which sequences are
+     * defined (e.g. 4 for DNA)
+     * @param sketch_dim the dimension of the embedded (sketched) space, denoted by D in the paper
+     * @param subsequence_len the length of the subsequences considered for sketching, denoted by t
+     * in the paper
+     * @param num_repetitions the number R of independent sketches computed for each sequence
+     * @param seed the seed to initialize the random number generator used for the random hash
+     * functions.
+     * @param reducer how #dist combines the distances of the R repetitions
+     */
+    TensorMulti(seq_type alphabet_size,
+                size_t sketch_dim,
+                size_t subsequence_len,
+                size_t num_repetitions,
+                uint32_t seed,
+                Reducer reducer = Reducer::median,
+                const std::string &name = "TS_multi")
+        : SketchBase<Vec2D<scalar_type>, false>(name),
+          alphabet_size(alphabet_size),
+          sketch_dim(sketch_dim),
+          subsequence_len(subsequence_len),
+          num_repetitions(num_repetitions),
+          reducer(reducer),
+          rng(seed) {
+        init();
+    }
+
+    void init() {
+        hashes = new3D<seq_type>(num_repetitions, subsequence_len, alphabet_size);
+        signs = new3D<bool>(num_repetitions, subsequence_len, alphabet_size);
+
+        std::uniform_int_distribution<seq_type> rand_hash2(0, sketch_dim - 1);
+        std::uniform_int_distribution<seq_type> rand_bool(0, 1);
+
+        for (size_t r = 0; r < num_repetitions; r++) {
+            for (size_t h = 0; h < subsequence_len; h++) {
+                for (size_t c = 0; c < alphabet_size; c++) {
+                    hashes[r][h][c] = rand_hash2(rng);
+                    signs[r][h][c] = rand_bool(rng);
+                }
+            }
+        }
+        flatten_hashes();
+    }
+
+    /**
+     * Computes the R sketches of the given sequence.
+     * @param seq the sequence to be sketched
+     * @return an R x #sketch_dim matrix, row r containing the sketch computed with the r-th set of
+     * hash functions
+     */
+    Vec2D<scalar_type> compute(const std::vector<seq_type> &seq) {
+        Timer timer("tensor_multi_sketch");
+        // Tp and Tm have the same meaning as in Tensor::compute; row p of repetition r starts at
+        // (p*R + r)*stride, so that the rows updated by the inner loop are contiguous
+        const size_t stride = aligned_len<scalar_type>(sketch_dim);
+        const size_t row_stride = num_repetitions * stride;
+        static thread_local AlignedVec<scalar_type> workspace;
+        workspace.assign(2 * (subsequence_len + 1) * row_stride, 0);
+        scalar_type *Tp = workspace.data();
+        scalar_type *Tm = Tp + (subsequence_len + 1) * row_stride;
+        for (size_t r = 0; r < num_repetitions; ++r) {
+            Tp[r * stride] = 1;
+        }
+
+        for (uint32_t i = 0; i < seq.size(); i++) {
+            const seq_type c = seq[i];
+            if (c < 0 or c >= alphabet_size) {
+                continue;
+            }
+            for (uint32_t p = std::min(i + 1, (uint32_t)subsequence_len); p >= 1; --p) {
+                const scalar_type z = p / (i + 1.0); // probability that the last index is i
+                const size_t first = ((p - 1) * alphabet_size + c) * num_repetitions;
+                for (size_t r = 0; r < num_repetitions; ++r) {
+                    const uint32_t shift = flat_hashes[first + r];
+                    scalar_type *tp = Tp + p * row_stride + r * stride;
+                    scalar_type *tm = Tm + p * row_stride + r * stride;
+                    // a negative sign swaps the roles of Tp and Tm of the previous row
+                    const bool s = flat_signs[first + r];
+                    ts::shift_sum(tp, tp, (s ? tp : tm) - row_stride, sketch_dim, shift, z);
+                    ts::shift_sum(tm, tm, (s ? tm : tp) - row_stride, sketch_dim, shift, z);
+                }
+            }
+        }
+
+        Vec2D<scalar_type> sketches = new2D<scalar_type>(num_repetitions, sketch_dim);
+        for (size_t r = 0; r < num_repetitions; ++r) {
+            const size_t offset = subsequence_len * row_stride + r * stride;
+            for (uint32_t m = 0; m < sketch_dim; m++) {
+                sketches[r][m] = Tp[offset + m] - Tm[offset + m];
+            }
+        }
+        return sketches;
+    }
+
+    /** Returns the distance of each of the R repetitions */
+    static std::vector<double> dist_per_repetition(const Vec2D<scalar_type> &a,
+                                                   const Vec2D<scalar_type> &b) {
+        assert(a.size() == b.size());
+        std::vector<double> dists(a.size());
+        for (size_t r = 0; r < a.size(); ++r) {
+            dists[r] = l2_dist<scalar_type, double>(a[r], b[r]);
+        }
+        return dists;
+    }
+
+    /** Returns the median or mean, depending on #reducer, of the distances of the repetitions */
+    double dist(const Vec2D<scalar_type> &a, const Vec2D<scalar_type> &b) const {
+        Timer timer("tensor_multi_sketch_dist");
+        std::vector<double> dists = dist_per_repetition(a, b);
+        if (dists.empty()) {
+            return 0;
+        }
+        if (reducer == Reducer::mean) {
+            return std::accumulate(dists.begin(), dists.end(), 0.0) / dists.size();
+        }
+        std::sort(dists.begin(), dists.end());
+        return median(dists);
+    }
+
+    /** Sets the hash and sign functions of all repetitions to predetermined values for testing */
+    void set_hashes_for_testing(const Vec3D<seq_type> &h, const Vec3D<bool> &s) {
+        assert(h.size() == num_repetitions && s.size() == num_repetitions);
+        hashes = h;
+        signs = s;
+        flatten_hashes();
+    }
+
+  private:
+    /**
+     * Copies #hashes and #signs into #flat_hashes and #flat_signs, where the values of all
+     * repetitions for tuple position p and character c are contiguous, so that the inner loop of
+     * #compute reads them from a single cache line.
+     */
+    void flatten_hashes() {
+        flat_hashes.resize(subsequence_len * alphabet_size * num_repetitions);
+        flat_signs.resize(flat_hashes.size());
+        for (size_t h = 0; h < subsequence_len; h++) {
+            for (size_t c = 0; c < alphabet_size; c++) {
+                for (size_t r = 0; r < num_repetitions; r++) {
+                    flat_hashes[(h * alphabet_size + c) * num_repetitions + r] = hashes[r][h][c];
+                    flat_signs[(h * alphabet_size + c) * num_repetitions + r] = signs[r][h][c];
+                }
+            }
+        }
+    }
+
+    /** Size of the alphabet over which sequences to be sketched are defined, e.g. 4 for DNA */
+    seq_type alphabet_size;
+    /** Number of elements in each sketch, denoted by D in the paper */
+    uint32_t sketch_dim;
+    /** The length of the subsequences considered for sketching, denoted by t in the paper */
+    uint8_t subsequence_len;
+    /** The number R of independent sketches computed for each sequence */
+    size_t num_repetitions;
+    /** How #dist combines the distances of the repetitions */
+    Reducer reducer;
+
+    /** hashes[r] are the hash functions h1...ht of repetition r */
+    Vec3D<seq_type> hashes;
+
+    /** signs[r] are the sign functions s1...st of repetition r */
+    Vec3D<bool> signs;
+
+    /** hashes[r][h][c] is stored at (h*alphabet_size + c)*R + r */
+    std::vector<uint32_t> flat_hashes;
+    /** signs[r][h][c] is stored at (h*alphabet_size + c)*R + r */
+    std::vector<uint8_t> flat_signs;
+
+    std::mt19937 rng;
+};
+
+} // namespace ts
@@ -2,9 +2,14 @@
 
 #include "tensor.hpp"
 
+#include "util/aligned_allocator.hpp"
 #include "util/utils.hpp"
 
+#include <omp.h>
+
+#include <algorithm>
 #include <cstddef>
+#include <iterator>
 #include <vector>
 
 namespace ts {
@@ -12,11 +17,15 @@ namespace ts {
  * Computes sliding tensor sketches for a given sequence as described in
  * https://www.biorxiv.org/content/10.1101/2020.11.13.381814v1
  * @tparam seq_type the type of elements in the sequences to be sketched.
+ * @tparam scalar_type the floating point type of the sketches. The intermediate state is always
+ * kept in double: removing a character from the window multiplies the state by 1+z>1, so rounding
+ * errors are amplified with each removal and a float state diverges by up to 1e-2 from the double
+ * one after a few hundred removals for t=6.
  */
-template <class seq_type>
-class TensorSlide : public Tensor<seq_type> {
+template <class seq_type, class scalar_type = double>
+class TensorSlide : public Tensor<seq_type, scalar_type> {
   public:
-    using sketch_type = Vec2D<double>;
+    using sketch_type = Vec2D<scalar_type>;
 
     /**
      * @param alphabet_size the number of elements in the alphabet S over which sequences are
@@ -37,7 +46,7 @@ class TensorSlide : public Tensor<seq_type> {
                 size_t stride,
                 uint32_t seed,
                 const std::string &name = "TSS")
-        : Tensor<seq_type>(alphabet_size, sketch_dim, tup_len, seed, name),
+        : Tensor<seq_type, scalar_type>(alphabet_size, sketch_dim, tup_len, seed, name),
           win_len(win_len),
           stride(stride) {
         assert(stride <= win_len && "Stride cannot be larger than the window length");
@@ -49,84 +58,186 @@ class TensorSlide : public Tensor<seq_type> {
      * A sketch is computed every #stride characters on substrings of length #window.
      * @return seq.size()/stride sketches of size #sketch_dim
      */
-    Vec2D<double> compute(const std::vector<seq_type> &seq) {
+    Vec2D<scalar_type> compute(const std::vector<seq_type> &seq) {
+        if (use_chunks(seq.size())) {
+            return compute_parallel(seq, omp_get_max_threads());
+        }
+        Timer timer("tensor_slide_sketch");
+        if (seq.size() < this->subsequence_len) {
+            return new2D<scalar_type>(seq.size() / this->stride, this->sketch_dim, scalar_type(0));
+        }
+        Vec2D<scalar_type> sketches;
+        slide(seq, 0, 0, seq.size(), collect_into(&sketches));
+        return sketches;
+    }
+
+    /**
+     * Computes the same sliding sketches as #compute, but passes each of them to #sink as soon as
+     * it is computed instead of storing them, so that the memory used doesn't grow with the length
+     * of #seq. The sketches are computed on the calling thread, in order.
+     * @param sink called as sink(index, sketch) for each sketch, where index is the position of the
+     * sketch in the output of #compute. The vector passed as sketch is reused for the following
+     * sketches, so it must be copied if needed after #sink returns.
+     */
+    template <class Sink>
+    void compute(const std::vector<seq_type> &seq, Sink &&sink) {
         Timer timer("tensor_slide_sketch");
-        Vec2D<double> sketches;
         if (seq.size() < this->subsequence_len) {
-            return new2D<double>(seq.size() / this->stride, this->sketch_dim, double(0));
+            const std::vector<scalar_type> zero(this->sketch_dim, 0);
+            for (size_t index = 0; index < seq.size() / stride; ++index) {
+                sink(index, zero);
+            }
+            return;
+        }
+        slide(seq, 0, 0, seq.size(), sink);
+    }
+
+    /**
+     * Computes the sliding sketches of #seq by splitting it into #num_chunks chunks that are
+     * sketched in parallel. A sketch only depends on the #win_len characters of its window, so each
+     * chunk is sketched independently after warming up its state on the #win_len characters
+     * preceding it, and the sketches of the chunks are concatenated in order.
+     * @return the same sketches as #compute, up to rounding errors
+     */
+    Vec2D<scalar_type> compute_parallel(const std::vector<seq_type> &seq, size_t num_chunks) {
+        Timer timer("tensor_slide_sketch_parallel");
+        if (seq.size() < this->subsequence_len) {
+            return new2D<scalar_type>(seq.size() / this->stride, this->sketch_dim, scalar_type(0));
+        }
+        num_chunks = std::max<size_t>(1, std::min(num_chunks, seq.size()));
+        std::vector<Vec2D<scalar_type>> chunk_sketches(num_chunks);
+#pragma omp parallel for default(shared)
+        for (size_t k = 0; k < num_chunks; ++k) {
+            const size_t begin = k * seq.size() / num_chunks;
+            const size_t end = (k + 1) * seq.size() / num_chunks;
+            slide(seq, begin > win_len ? begin - win_len : 0, begin, end,
+                  collect_into(&chunk_sketches[k]));
         }
+
+        Vec2D<scalar_type> sketches;
+        sketches.reserve(seq.size() / stride);
+        for (Vec2D<scalar_type> &chunk : chunk_sketches) {
+            std::move(chunk.begin(), chunk.end(), std::back_inserter(sketches));
+        }
+        return sketches;
+    }
+
+    double dist(const Vec2D<scalar_type> &a, const Vec2D<scalar_type> &b) {
+        Timer timer("tensor_slide_sketch_dist");
+        return l2_dist2D_minlen<scalar_type, double>(a, b);
+    }
+
+
+  private:
+    /**
+     * Whether #compute splits #seq into chunks. Each chunk repeats the work for the #win_len
+     * characters before it, so the chunks must be much longer than the window to pay off.
+     */
+    bool use_chunks(size_t len) const {
+        const size_t num_threads = omp_get_max_threads();
+        return len >= this->kMinParallelLen && !omp_in_parallel() && num_threads > 1
+                && len / num_threads >= 8 * win_len;
+    }
+
+    /** Returns a sink for #slide that appends the sketches to #sketches */
+    static auto collect_into(Vec2D<scalar_type> *sketches) {
+        return [sketches](size_t, const std::vector<scalar_type> &sketch) {
+            sketches->push_back(sketch);
+        };
+    }
+
+    /**
+     * Runs the sliding recurrence on seq[from...end-1], starting with an empty window at #from, and
+     * passes to #sink the sketches for the positions first...end-1 at which #compute outputs one,
+     * as described in #compute(seq, sink). For first >= from + #win_len, the window is full at
+     * #first and the sketches are the same as when starting at 0.
+     */
+    template <class Sink>
+    void slide(const std::vector<seq_type> &seq,
+               size_t from,
+               size_t first,
+               size_t end,
+               Sink &&sink) const {
         auto &hashes = this->hashes;
         auto &signs = this->signs;
         auto tup_len = this->subsequence_len;
-        // first index: p; second index: q; third index: r
-        // p,q go from 1 to tup_len; p==0 and p==tup_len+1 are sentinels for termination condition
-        auto T1 = new3D<double>(tup_len + 2, tup_len + 1, this->sketch_dim, 0);
-        auto T2 = new3D<double>(tup_len + 2, tup_len + 1, this->sketch_dim, 0);
+        // T1 and T2 hold the cells (p,q) with 1<=p<=tup_len+1 and p-1<=q<=tup_len, each of
+        // #sketch_dim elements. The cells (p,p-1) are sentinels for the termination condition, the
+        // cells with q<p-1 are never used and are not stored. The cells (p,p-1),...,(p,tup_len) are
+        // consecutive, so (p,q-1) is the cell right before (p,q).
+        const size_t dim_stride = aligned_len<double>(this->sketch_dim);
+        std::vector<size_t> first_cell(tup_len + 2); // index of cell (p,p-1)
+        for (uint32_t p = 1; p <= tup_len; p++) {
+            first_cell[p + 1] = first_cell[p] + tup_len - p + 2;
+        }
+        const size_t num_cells = first_cell[tup_len + 1] + 1;
+        auto cell = [&](uint32_t p, uint32_t q) {
+            return (first_cell[p] + q + 1 - p) * dim_stride;
+        };
+        static thread_local AlignedVec<double> workspace;
+        workspace.assign(2 * num_cells * dim_stride, 0);
+        double *T1 = workspace.data();
+        double *T2 = T1 + num_cells * dim_stride;
 
         for (uint32_t p = 0; p <= tup_len; p++) {
-            T1[p + 1][p][0] = 1;
+            T1[cell(p + 1, p)] = 1;
         }
+        std::vector<scalar_type> sketch(this->sketch_dim);
 
-        // T[p][q] at step i represents the sketch for seq[i-w+1]...seq[i] when only using hash
+        // T[p][q] at step j represents the sketch for seq[j-w+1]...seq[j] when only using hash
         // functions 1<=p,p+1,...q<=t, where t is the sketch size
-        for (uint32_t i = 0; i < seq.size(); i++) {
+        for (size_t j = from; j < end; j++) {
+            const uint32_t i = j - from; // the position in the window started at #from
+            const seq_type c = seq[j];
             for (uint32_t p = 1; p <= tup_len; p++) {
                 // q-p must be smaller than i, hence the min in the condition
                 for (uint32_t q = std::min(p + i, (uint32_t)tup_len); q >= p; q--) {
                     double z = (double)(q - p + 1) / std::min(i + 1, win_len + 1);
-                    auto r = hashes[q - 1][seq[i]];
-                    bool s = signs[q - 1][seq[i]];
+                    auto r = hashes[q - 1][c];
+                    bool s = signs[q - 1][c];
+                    double *t1 = T1 + cell(p, q);
+                    double *t2 = T2 + cell(p, q);
                     if (s) {
-                        this->shift_sum_inplace(T1[p][q], T1[p][q - 1], r, z);
-                        this->shift_sum_inplace(T2[p][q], T2[p][q - 1], r, z);
+                        this->shift_sum_inplace(t1, t1 - dim_stride, r, z);
+                        this->shift_sum_inplace(t2, t2 - dim_stride, r, z);
                     } else {
-                        this->shift_sum_inplace(T1[p][q], T2[p][q - 1], r, z);
-                        this->shift_sum_inplace(T2[p][q], T1[p][q - 1], r, z);
+                        this->shift_sum_inplace(t1, t2 - dim_stride, r, z);
+                        this->shift_sum_inplace(t2, t1 - dim_stride, r, z);
                     }
                 }
             }
 
             if (i >= win_len) { // only start deleting from front after reaching #win_len
-                uint32_t ws = i - win_len; // the element to be removed from the sketch
+                const seq_type removed = seq[j - win_len]; // the element to be removed
                 for (uint32_t diff = 0; diff < tup_len; ++diff) {
                     for (uint32_t p = 1; p <= tup_len - diff; p++) {
-                        auto r = hashes[p - 1][seq[ws]];
-                        bool s = signs[p - 1][seq[ws]];
+                        auto r = hashes[p - 1][removed];
+                        bool s = signs[p - 1][removed];
                         uint32_t q = p + diff;
                         // this computes t/(w-t); in our case t (the tuple length) is diff+1
                         double z = (double)(diff + 1) / (win_len - diff);
+                        double *t1 = T1 + cell(p, q);
+                        double *t2 = T2 + cell(p, q);
                         if (s) {
-                            this->shift_sum_inplace(T1[p][q], T1[p + 1][q], r, -z);
-                            this->shift_sum_inplace(T2[p][q], T2[p + 1][q], r, -z);
+                            this->shift_sum_inplace(t1, T1 + cell(p + 1, q), r, -z);
+                            this->shift_sum_inplace(t2, T2 + cell(p + 1, q), r, -z);
                         } else {
-                            this->shift_sum_inplace(T1[p][q], T2[p + 1][q], r, -z);
-                            this->shift_sum_inplace(T2[p][q], T1[p + 1][q], r, -z);
+                            this->shift_sum_inplace(t1, T2 + cell(p + 1, q), r, -z);
+                            this->shift_sum_inplace(t2, T1 + cell(p + 1, q), r, -z);
                         }
                     }
                 }
             }
 
-            if ((i + 1) % stride == 0) { // save a sketch every stride times
-                sketches.push_back(diff(T1[1].back(), T2[1].back()));
+            if (j >= first && (j + 1) % stride == 0) { // output a sketch every stride times
+                const double *t1 = T1 + cell(1, tup_len);
+                const double *t2 = T2 + cell(1, tup_len);
+                for (uint32_t m = 0; m < sketch.size(); ++m) {
+                    sketch[m] = t1[m] - t2[m];
+                }
+                sink((j + 1) / stride - 1, sketch);
             }
         }
-        return sketches;
-    }
-
-    double dist(const Vec2D<double> &a, const Vec2D<double> &b) {
-        Timer timer("tensor_slide_sketch_dist");
-        return l2_dist2D_minlen(a, b);
-    }
-
-
-  private:
-    std::vector<double> diff(const std::vector<double> &a, const std::vector<double> &b) {
-        assert(a.size() == b.size());
-        std::vector<double> result(a.size());
-        for (uint32_t i = 0; i < result.size(); ++i) {
-            result[i] = a[i] - b[i];
-        }
-        return result;
     }
 
     uint32_t win_len;
@@ -4,8 +4,10 @@ namespace ts {
 
 /**
  * A wrapper class around TensorSlide that flattens the output of TensorSlide::compute() from a 2D
- * vector to a 1D vector. The Flattener type must have a .flatten method that does the conversion.
- * Typically used with a class form sketch/dim_reduce.h.
+ * vector to a 1D vector. The Flattener type must provide the linear projection of the sketches
+ * through its .accumulator, .add and .finish methods, which are fed each sketch as soon as it is
+ * computed, so that the sliding sketches are never stored. Typically used with a class form
+ * sketch/dim_reduce.h.
  *
  * @tparam seq_type the type of elements in the sequences to be sketched.
  * @tparam Flattener: one of the classes from util/dim_reduce.h.
@@ -47,7 +49,13 @@ class TensorSlideFlat : public TensorSlide<seq_type> {
      * @return seq.size()/stride sketches of size #sketch_dim
      */
     sketch_type compute(const std::vector<seq_type> &seq) {
-        return flattener.flatten(TensorSlide<seq_type>::compute(seq));
+        std::vector<double> acc = flattener.accumulator();
+        size_t num_sketches = 0;
+        TensorSlide<seq_type>::compute(seq, [&](size_t index, const std::vector<double> &sketch) {
+            flattener.add(index, sketch, &acc);
+            num_sketches++;
+        });
+        return flattener.finish(std::move(acc), num_sketches);
     }
 
     static double dist(const sketch_type &a, const sketch_type &b) { return Flattener::dist(a, b); }
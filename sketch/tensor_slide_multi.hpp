@@ -0,0 +1,186 @@
+#pragma once
+
+#include "sketch/tensor.hpp"
+#include "util/aligned_allocator.hpp"
+#include "util/multivec.hpp"
+#include "util/timer.hpp"
+#include "util/utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace ts { // ts = Tensor Sketch
+
+/**
+ * Computes the sliding tensor sketches of a sequence for several window lengths in a single pass.
+ * The sketches for window length win_lens[k] are the same as computed by a TensorSlide with that
+ * window length and the same hash functions. The states of the windows differ as soon as the
+ * shortest window is full, so each window keeps its own state, but the traversal of the sequence,
+ * the hash and sign lookups of the add pass and the loops over (p,q) are shared. The cells (p,q)
+ * of all windows are stored next to each other, so that the inner loops over the windows read
+ * consecutive memory.
+ * @tparam seq_type the type of elements in the sequences to be sketched.
+ * @tparam scalar_type the floating point type of the sketches. As in TensorSlide, the intermediate
+ * state is always kept in double.
+ */
+template <class seq_type, class scalar_type = double>
+class TensorSlideMulti : public Tensor<seq_type, scalar_type> {
+  public:
+    /** The sketches for each window length: sketch_type[k] is the output of TensorSlide */
+    using sketch_type = Vec3D<scalar_type>;
+
+    /**
+     * @param alphabet_size the number of elements in the alphabet S over which sequences are
+     * defined (e.g. 4 for DNA)
+     * @param sketch_dim the dimension of the embedded (sketched) space, denoted by D in the paper
+     * @param tup_len the length of the subsequences considered for sketching, denoted by t
+     * in the paper
+     * @param win_lens sliding sketches are computed for substrings of each of these sizes
+     * @param stride sliding sketches are computed every stride characters, for all window lengths
+     * @param seed the seed to initialize the random number generator used for the random hash
+     * functions.
+     * @param name the name of the algorithm in the output
+     */
+    TensorSlideMulti(seq_type alphabet_size,
+                     size_t sketch_dim,
+                     size_t tup_len,
+                     const std::vector<uint32_t> &win_lens,
+                     size_t stride,
+                     uint32_t seed,
+                     const std::string &name = "TSS_multi")
+        : Tensor<seq_type, scalar_type>(alphabet_size, sketch_dim, tup_len, seed, name),
+          win_lens(win_lens),
+          stride(stride) {
+        for (uint32_t win_len : win_lens) {
+            assert(stride <= win_len && "Stride cannot be larger than the window length");
+            assert(tup_len <= win_len && "Tuple length (t) cannot be larger than the window length");
+        }
+    }
+
+    /**
+     * Computes sliding sketches for the given sequence and each window length.
+     * @return a vector containing, for each window length win_lens[k], seq.size()/stride sketches
+     * of size #sketch_dim
+     */
+    Vec3D<scalar_type> compute(const std::vector<seq_type> &seq) {
+        Timer timer("tensor_slide_multi_sketch");
+        const size_t num_windows = win_lens.size();
+        if (seq.size() < this->subsequence_len) {
+            return new3D<scalar_type>(num_windows, seq.size() / stride, this->sketch_dim, 0);
+        }
+        Vec3D<scalar_type> sketches(num_windows);
+        auto &hashes = this->hashes;
+        auto &signs = this->signs;
+        const uint32_t tup_len = this->subsequence_len;
+        // The cells (p,q) are the ones of TensorSlide::compute, in the same order. Cell (p,q) of
+        // window k starts at (cell(p,q)*num_windows + k)*dim_stride, so (p,q-1) of window k is
+        // cell_stride before (p,q) of window k.
+        const size_t dim_stride = aligned_len<double>(this->sketch_dim);
+        const size_t cell_stride = num_windows * dim_stride;
+        std::vector<size_t> first_cell(tup_len + 2); // index of cell (p,p-1)
+        for (uint32_t p = 1; p <= tup_len; p++) {
+            first_cell[p + 1] = first_cell[p] + tup_len - p + 2;
+        }
+        const size_t num_cells = first_cell[tup_len + 1] + 1;
+        auto cell = [&](uint32_t p, uint32_t q) {
+            return (first_cell[p] + q + 1 - p) * cell_stride;
+        };
+        static thread_local AlignedVec<double> workspace;
+        workspace.assign(2 * num_cells * cell_stride, 0);
+        double *T1 = workspace.data();
+        double *T2 = T1 + num_cells * cell_stride;
+
+        for (uint32_t p = 0; p <= tup_len; p++) {
+            for (size_t k = 0; k < num_windows; ++k) {
+                T1[cell(p + 1, p) + k * dim_stride] = 1;
+            }
+        }
+
+        for (uint32_t i = 0; i < seq.size(); i++) {
+            const seq_type c = seq[i];
+            for (uint32_t p = 1; p <= tup_len; p++) {
+                // q-p must be smaller than i, hence the min in the condition
+                for (uint32_t q = std::min(p + i, tup_len); q >= p; q--) {
+                    const auto r = hashes[q - 1][c];
+                    const bool s = signs[q - 1][c];
+                    for (size_t k = 0; k < num_windows; ++k) {
+                        double z = (double)(q - p + 1) / std::min(i + 1, win_lens[k] + 1);
+                        double *t1 = T1 + cell(p, q) + k * dim_stride;
+                        double *t2 = T2 + cell(p, q) + k * dim_stride;
+                        if (s) {
+                            this->shift_sum_inplace(t1, t1 - cell_stride, r, z);
+                            this->shift_sum_inplace(t2, t2 - cell_stride, r, z);
+                        } else {
+                            this->shift_sum_inplace(t1, t2 - cell_stride, r, z);
+                            this->shift_sum_inplace(t2, t1 - cell_stride, r, z);
+                        }
+                    }
+                }
+            }
+
+            // each window removes its own first character, once it has reached its length
+            for (size_t k = 0; k < num_windows; ++k) {
+                const uint32_t win_len = win_lens[k];
+                if (i < win_len) {
+                    continue;
+                }
+                const seq_type removed = seq[i - win_len];
+                for (uint32_t diff = 0; diff < tup_len; ++diff) {
+                    // this computes t/(w-t); in our case t (the tuple length) is diff+1
+                    const double z = (double)(diff + 1) / (win_len - diff);
+                    for (uint32_t p = 1; p <= tup_len - diff; p++) {
+                        const auto r = hashes[p - 1][removed];
+                        const bool s = signs[p - 1][removed];
+                        const uint32_t q = p + diff;
+                        double *t1 = T1 + cell(p, q) + k * dim_stride;
+                        double *t2 = T2 + cell(p, q) + k * dim_stride;
+                        const double *next1 = T1 + cell(p + 1, q) + k * dim_stride;
+                        const double *next2 = T2 + cell(p + 1, q) + k * dim_stride;
+                        this->shift_sum_inplace(t1, s ? next1 : next2, r, -z);
+                        this->shift_sum_inplace(t2, s ? next2 : next1, r, -z);
+                    }
+                }
+            }
+
+            if ((i + 1) % stride == 0) { // save a sketch every stride times
+                for (size_t k = 0; k < num_windows; ++k) {
+                    const double *t1 = T1 + cell(1, tup_len) + k * dim_stride;
+                    const double *t2 = T2 + cell(1, tup_len) + k * dim_stride;
+                    std::vector<scalar_type> sketch(this->sketch_dim);
+                    for (uint32_t m = 0; m < sketch.size(); ++m) {
+                        sketch[m] = t1[m] - t2[m];
+                    }
+                    sketches[k].push_back(std::move(sketch));
+                }
+            }
+        }
+        return sketches;
+    }
+
+    /** Returns the distance between the sketches of each window length, as in TensorSlide */
+    static std::vector<double> dist_per_window(const Vec3D<scalar_type> &a,
+                                               const Vec3D<scalar_type> &b) {
+        assert(a.size() == b.size());
+        std::vector<double> dists(a.size());
+        for (size_t k = 0; k < a.size(); ++k) {
+            dists[k] = l2_dist2D_minlen<scalar_type, double>(a[k], b[k]);
+        }
+        return dists;
+    }
+
+    /** Returns the sum of the distances of all window lengths */
+    double dist(const Vec3D<scalar_type> &a, const Vec3D<scalar_type> &b) {
+        Timer timer("tensor_slide_multi_sketch_dist");
+        const std::vector<double> dists = dist_per_window(a, b);
+        return std::accumulate(dists.begin(), dists.end(), 0.0);
+    }
+
+  private:
+    std::vector<uint32_t> win_lens;
+    uint32_t stride;
+};
+
+} // namespace ts
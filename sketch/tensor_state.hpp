@@ -0,0 +1,150 @@
+#pragma once
+
+#include "sketch/tensor.hpp"
+#include "util/aligned_allocator.hpp"
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+namespace ts { // ts = Tensor Sketch
+
+/**
+ * The state of a tensor sketch over a sequence that is not fully known in advance, e.g. because it
+ * is read from a stream or because it is a growing assembly. Characters are appended with #update,
+ * and #finalize returns the sketch of all the characters seen so far, which is bit for bit the same
+ * as Tensor::compute on their concatenation. The state can be saved to and loaded from a stream in
+ * order to pause and resume long jobs.
+ * @tparam seq_type the type of elements in the sequences to be sketched.
+ * @tparam scalar_type the floating point type of the sketch and of the intermediate state
+ */
+template <class seq_type, class scalar_type = double>
+class TensorState {
+  public:
+    /**
+     * Creates the state of the empty sequence.
+     * @param sketcher provides the hash functions and dimensions; must outlive this object
+     */
+    explicit TensorState(const Tensor<seq_type, scalar_type> &sketcher)
+        : sketcher(&sketcher),
+          stride(aligned_len<scalar_type>(sketcher.sketch_dim)),
+          state(2 * num_rows() * stride, 0) {
+        // the sketch of the empty string is (1,0,...)
+        state[0] = 1;
+    }
+
+    /** Appends the characters chunk[0...n-1] to the sketched sequence */
+    void update(const seq_type *chunk, size_t n) {
+        sketcher->advance(Tp(), Tm(), stride, chunk, n, length);
+        length += n;
+    }
+
+    /**
+     * Returns the sketch of the characters seen so far. The state is not modified, so more
+     * characters can be appended afterwards.
+     */
+    std::vector<scalar_type> finalize() const {
+        const size_t t = sketcher->subsequence_len;
+        std::vector<scalar_type> sketch(sketcher->sketch_dim);
+        for (uint32_t m = 0; m < sketch.size(); m++) {
+            sketch[m] = Tp()[t * stride + m] - Tm()[t * stride + m];
+        }
+        return sketch;
+    }
+
+    /** The number of characters seen so far, including the ones outside the alphabet */
+    uint64_t size() const { return length; }
+
+    /**
+     * Writes the state to #out in a binary format, using the native byte order. The hash functions
+     * are not saved, only a checksum of them, so the state can only be loaded by a TensorState
+     * using the same sketcher (or one with the same seed and parameters).
+     */
+    void save(std::ostream &out) const {
+        write(out, kMagic);
+        write(out, kVersion);
+        write(out, (uint32_t)sketcher->sketch_dim);
+        write(out, (uint32_t)sketcher->subsequence_len);
+        write(out, (uint32_t)sizeof(scalar_type));
+        write(out, hashes_checksum());
+        write(out, length);
+        for (size_t row = 0; row < 2 * num_rows(); ++row) {
+            out.write(reinterpret_cast<const char *>(state.data() + row * stride),
+                      sketcher->sketch_dim * sizeof(scalar_type));
+        }
+    }
+
+    /**
+     * Replaces this state with the one written by #save to #in.
+     * @throw std::invalid_argument if #in doesn't contain a state for the same sketcher
+     */
+    void load(std::istream &in) {
+        if (read<uint32_t>(in) != kMagic || read<uint32_t>(in) != kVersion) {
+            throw std::invalid_argument("Not a tensor sketch state");
+        }
+        if (read<uint32_t>(in) != sketcher->sketch_dim
+            || read<uint32_t>(in) != sketcher->subsequence_len
+            || read<uint32_t>(in) != sizeof(scalar_type) || read<uint64_t>(in) != hashes_checksum()) {
+            throw std::invalid_argument("Tensor sketch state was saved by a different sketcher");
+        }
+        const uint64_t new_length = read<uint64_t>(in);
+        AlignedVec<scalar_type> new_state(state.size(), 0);
+        for (size_t row = 0; row < 2 * num_rows(); ++row) {
+            in.read(reinterpret_cast<char *>(new_state.data() + row * stride),
+                    sketcher->sketch_dim * sizeof(scalar_type));
+        }
+        if (!in) {
+            throw std::invalid_argument("Truncated tensor sketch state");
+        }
+        length = new_length;
+        state = std::move(new_state);
+    }
+
+  private:
+    static constexpr uint32_t kMagic = 0x54535354; // "TSST"
+    static constexpr uint32_t kVersion = 1;
+
+    size_t num_rows() const { return sketcher->subsequence_len + 1; }
+
+    /** Tp and Tm have the same meaning and layout as in Tensor::compute */
+    scalar_type *Tp() { return state.data(); }
+    scalar_type *Tm() { return state.data() + num_rows() * stride; }
+    const scalar_type *Tp() const { return state.data(); }
+    const scalar_type *Tm() const { return state.data() + num_rows() * stride; }
+
+    /** FNV-1a hash of the hash and sign functions of #sketcher */
+    uint64_t hashes_checksum() const {
+        uint64_t checksum = 0xcbf29ce484222325ULL;
+        for (size_t p = 0; p < sketcher->hashes.size(); ++p) {
+            for (size_t c = 0; c < sketcher->hashes[p].size(); ++c) {
+                checksum = (checksum ^ (uint64_t)sketcher->hashes[p][c]) * 0x100000001b3ULL;
+                checksum = (checksum ^ (uint64_t)sketcher->signs[p][c]) * 0x100000001b3ULL;
+            }
+        }
+        return checksum;
+    }
+
+    template <class T>
+    static void write(std::ostream &out, T value) {
+        out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <class T>
+    static T read(std::istream &in) {
+        T value = 0;
+        in.read(reinterpret_cast<char *>(&value), sizeof(T));
+        return value;
+    }
+
+    const Tensor<seq_type, scalar_type> *sketcher;
+    /** Distance between consecutive rows of #state */
+    size_t stride;
+    /** The number of characters seen so far */
+    uint64_t length = 0;
+    /** The rows of Tp followed by the rows of Tm */
+    AlignedVec<scalar_type> state;
+};
+
+} // namespace ts
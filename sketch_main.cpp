@@ -2,12 +2,17 @@
 #include "sequence/fasta_io.hpp"
 #include "sketch/edit_distance.hpp"
 #include "sketch/hash_base.hpp"
+#include "sketch/hash_icws.hpp"
 #include "sketch/hash_min.hpp"
+#include "sketch/hash_one_perm.hpp"
 #include "sketch/hash_ordered.hpp"
 #include "sketch/hash_weighted.hpp"
 #include "sketch/tensor.hpp"
 #include "sketch/tensor_block.hpp"
+#include "sketch/tensor_decay.hpp"
 #include "sketch/tensor_embedding.hpp"
+#include "sketch/tensor_embedding_sparse.hpp"
+#include "sketch/tensor_fixed.hpp"
 #include "sketch/tensor_slide.hpp"
 #include "util/multivec.hpp"
 #include "util/progress.hpp"
@@ -35,10 +40,10 @@ DEFINE_string(alphabet,
 
 DEFINE_string(sketch_method,
               "TSS",
-              "The sketching method to use: MH, WMH, OMH, TS, TSB or TSS");
+              "The sketching method to use: MH, WMH, ICWS, OMH, OPH, TE, TES, TS, TSB, TSS or TSD");
 DEFINE_string(m, "TSS", "Short hand for --sketch_method");
 
-DEFINE_uint32(kmer_length, 1, "The kmer length for: MH, WMH, OMH");
+DEFINE_uint32(kmer_length, 1, "The kmer length for: MH, WMH, ICWS, OMH, OPH");
 DEFINE_uint32(k, 3, "Short hand for --kmer_length");
 
 DEFINE_string(o, "", "Output file, containing the sketches for each sequence");
@@ -69,11 +74,29 @@ DEFINE_int32(block_size,
              "Only consider tuples made out of block-size continuous characters for Tensor sketch");
 DEFINE_validator(block_size, &ValidateBlockSize);
 
+DEFINE_bool(count_mode,
+            false,
+            "Compute Tensor sketches (TS) by counting subsequences and normalizing at the end; "
+            "faster, and exact for sequences with less than ~2^62 subsequences");
+
 DEFINE_int32(window_size, 32, "Window length: the size of sliding window in Tensor Slide Sketch");
 DEFINE_int32(w, 32, "Short hand for --window_size");
 
 DEFINE_int32(max_len, 32, "The maximum accepted sequence length for Ordered and Weighted min-hash");
 
+static bool ValidateHashAlg(const char *flagname, const std::string &value) {
+    if (value == "uniform" || value == "crc32" || value == "murmur" || value == "mix32") {
+        return true;
+    }
+    std::cerr << "Invalid value for --" << flagname << ": " << value << std::endl;
+    return false;
+}
+DEFINE_string(hash_alg,
+              "murmur",
+              "Hash algorithm used by MH, WMH, ICWS, OMH and OPH: 'murmur', 'uniform', 'crc32', or "
+              "'mix32'");
+DEFINE_validator(hash_alg, &ValidateHashAlg);
+
 DEFINE_int32(stride, 8, "Stride for sliding window: shift step for sliding window");
 DEFINE_int32(s, 8, "Short hand for --stride");
 
@@ -185,6 +208,18 @@ void run_triangle(SketchAlgorithm &algorithm) {
     fo.close();
 };
 
+// Runs function f on a TensorFixed<t, D> for the first D in Ds that matches the command line
+// options. Returns false if there is no match, i.e. the generic Tensor must be used.
+template <uint32_t t, uint32_t... Ds, typename F>
+bool run_function_on_tensor_fixed(F f, seq_type alphabet_size, uint32_t seed) {
+    if (FLAGS_tuple_length != (int32_t)t) {
+        return false;
+    }
+    return ((FLAGS_embed_dim == (int32_t)Ds
+             && (f(TensorFixed<seq_type, t, Ds>(alphabet_size, seed)), true))
+            || ...);
+}
+
 // Runs function f on the sketch method specified by the command line options.
 template <typename F>
 void run_function_on_algorithm(F f) {
@@ -193,18 +228,43 @@ void run_function_on_algorithm(F f) {
     auto kmer_word_size = int_pow<kmer_type>(alphabet_size, FLAGS_kmer_length);
 
     std::random_device rd;
+    // the min-hash sketches are instantiated for the hash algorithm given by --hash_alg
+    const HashAlgorithm hash_algorithm = parse_hash_algorithm(FLAGS_hash_alg);
     if (FLAGS_sketch_method == "MH") {
-        f(MinHash<kmer_type>(kmer_word_size, FLAGS_embed_dim, HashAlgorithm::murmur, rd()));
+        run_function_on_hash_algorithm(hash_algorithm, [&](auto hash) {
+            constexpr HashAlgorithm kHash = decltype(hash)::value;
+            f(MinHash<kmer_type, kHash>(kmer_word_size, FLAGS_embed_dim, rd()));
+        });
         return;
     }
     if (FLAGS_sketch_method == "WMH") {
-        f(WeightedMinHash<kmer_type>(kmer_word_size, FLAGS_embed_dim, FLAGS_max_len,
-                                     HashAlgorithm::murmur, rd()));
+        run_function_on_hash_algorithm(hash_algorithm, [&](auto hash) {
+            constexpr HashAlgorithm kHash = decltype(hash)::value;
+            f(WeightedMinHash<kmer_type, kHash>(kmer_word_size, FLAGS_embed_dim, FLAGS_max_len,
+                                                rd()));
+        });
+        return;
+    }
+    if (FLAGS_sketch_method == "ICWS") {
+        run_function_on_hash_algorithm(hash_algorithm, [&](auto hash) {
+            constexpr HashAlgorithm kHash = decltype(hash)::value;
+            f(ConsistentWeightedMinHash<kmer_type, kHash>(kmer_word_size, FLAGS_embed_dim, rd()));
+        });
         return;
     }
     if (FLAGS_sketch_method == "OMH") {
-        f(OrderedMinHash<kmer_type>(kmer_word_size, FLAGS_embed_dim, FLAGS_max_len,
-                                    FLAGS_tuple_length, HashAlgorithm::murmur, rd()));
+        run_function_on_hash_algorithm(hash_algorithm, [&](auto hash) {
+            constexpr HashAlgorithm kHash = decltype(hash)::value;
+            f(OrderedMinHash<kmer_type, kHash>(kmer_word_size, FLAGS_embed_dim, FLAGS_max_len,
+                                               FLAGS_tuple_length, rd()));
+        });
+        return;
+    }
+    if (FLAGS_sketch_method == "OPH") {
+        run_function_on_hash_algorithm(hash_algorithm, [&](auto hash) {
+            constexpr HashAlgorithm kHash = decltype(hash)::value;
+            f(OnePermMinHash<kmer_type, kHash>(kmer_word_size, FLAGS_embed_dim, rd()));
+        });
         return;
     }
     if (FLAGS_sketch_method == "ED") {
@@ -215,8 +275,18 @@ void run_function_on_algorithm(F f) {
         f(TensorEmbedding<seq_type>(alphabet_size, FLAGS_tuple_length, "TensorEmbedding"));
         return;
     }
+    if (FLAGS_sketch_method == "TES") {
+        f(TensorEmbeddingSparse<seq_type>(alphabet_size, FLAGS_tuple_length,
+                                          "TensorEmbeddingSparse"));
+        return;
+    }
     if (FLAGS_sketch_method == "TS") {
-        f(Tensor<seq_type>(kmer_word_size, FLAGS_embed_dim, FLAGS_tuple_length, rd()));
+        // the configurations used in production get a Tensor specialized at compile time
+        if (FLAGS_count_mode
+            || !run_function_on_tensor_fixed<3, 4, 16, 64>(f, kmer_word_size, rd())) {
+            f(Tensor<seq_type>(kmer_word_size, FLAGS_embed_dim, FLAGS_tuple_length, rd(), "TS",
+                               FLAGS_count_mode));
+        }
         return;
     }
     if (FLAGS_sketch_method == "TSB") {
@@ -229,6 +299,11 @@ void run_function_on_algorithm(F f) {
                                 FLAGS_window_size, FLAGS_stride, rd()));
         return;
     }
+    if (FLAGS_sketch_method == "TSD") {
+        f(TensorDecay<seq_type>(kmer_word_size, FLAGS_embed_dim, FLAGS_tuple_length,
+                                FLAGS_window_size, FLAGS_stride, rd()));
+        return;
+    }
     std::cerr << "Unknown sketch method: " << FLAGS_sketch_method << "\n";
 }
 
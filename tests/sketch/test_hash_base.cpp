@@ -2,6 +2,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <random>
 #include <unordered_map>
 #include <unordered_set>
@@ -16,14 +17,13 @@ constexpr uint8_t SET_SIZE = 4 * 4;
 constexpr uint32_t MAX_LEN = 3;
 constexpr uint8_t HASH_SIZE = MAX_LEN * SET_SIZE;
 
-class Hash : public HashBase<uint32_t>, public testing::TestWithParam<HashAlgorithm> {
+class Hash : public HashBase<uint32_t, HashAlgorithm::uniform>, public testing::Test {
   public:
     Hash()
-            : HashBase<uint32_t>(SET_SIZE,
-                                 SKETCH_DIM,
-                                 HASH_SIZE,
-                                 HashAlgorithm::uniform,
-            /*seed=*/31415) {}
+        : HashBase<uint32_t, HashAlgorithm::uniform>(SET_SIZE,
+                                                     SKETCH_DIM,
+                                                     HASH_SIZE,
+                                                     /*seed=*/31415) {}
 };
 
 // test that the uniform hash function is bijective, i.e. it is in effect a permutation:
@@ -39,40 +39,80 @@ TEST_F(Hash, HashesDistinct) {
     }
 }
 
-class Hash2 : public HashBase<uint32_t>, public testing::TestWithParam<HashAlgorithm> {
+class Uniform : public HashBase<uint32_t, HashAlgorithm::uniform> {
+  public:
+    Uniform(uint32_t hash_size, uint32_t seed)
+        : HashBase<uint32_t, HashAlgorithm::uniform>(hash_size, SKETCH_DIM, hash_size, seed) {}
+
+    std::vector<uint32_t> permutation(uint32_t s) {
+        std::vector<uint32_t> values(hash_size);
+        for (uint32_t i = 0; i < hash_size; ++i) {
+            values[i] = this->hash(s, i);
+        }
+        return values;
+    }
+};
+
+// test that the uniform hash functions are permutations also when the hash size is not a power of 2
+TEST(Uniform, Permutation) {
+    for (uint32_t hash_size : { 1, 2, 3, 5, 17, 1000, 4097, 100003 }) {
+        Uniform under_test(hash_size, /*seed=*/31415);
+        for (uint32_t s = 0; s < SKETCH_DIM; ++s) {
+            std::vector<uint32_t> values = under_test.permutation(s);
+            std::sort(values.begin(), values.end());
+            for (uint32_t i = 0; i < values.size(); ++i) {
+                ASSERT_EQ(i, values[i]) << "hash_size=" << hash_size << " s=" << s;
+            }
+        }
+    }
+}
+
+// test that the permutations are determined by the seed and differ between hash functions
+TEST(Uniform, DeterministicFromSeed) {
+    Uniform a(1000, /*seed=*/31415);
+    Uniform b(1000, /*seed=*/31415);
+    Uniform c(1000, /*seed=*/27182);
+    for (uint32_t s = 0; s < SKETCH_DIM; ++s) {
+        ASSERT_EQ(a.permutation(s), b.permutation(s));
+        ASSERT_NE(a.permutation(s), c.permutation(s));
+    }
+    ASSERT_NE(a.permutation(0), a.permutation(1));
+}
+
+template <typename Algorithm>
+class Hash2 : public HashBase<uint32_t, Algorithm::value>, public testing::Test {
   public:
     Hash2()
-        : HashBase<uint32_t>(SET_SIZE,
-                             SKETCH_DIM,
-                             HASH_SIZE,
-                             GetParam(),
-                             /*seed=*/31415) {}
+        : HashBase<uint32_t, Algorithm::value>(SET_SIZE,
+                                               SKETCH_DIM,
+                                               HASH_SIZE,
+                                               /*seed=*/31415) {}
 };
 
+using Algorithms = ::testing::Types<std::integral_constant<HashAlgorithm, HashAlgorithm::uniform>,
+                                    std::integral_constant<HashAlgorithm, HashAlgorithm::crc32>,
+                                    std::integral_constant<HashAlgorithm, HashAlgorithm::murmur>,
+                                    std::integral_constant<HashAlgorithm, HashAlgorithm::mix32>>;
+TYPED_TEST_SUITE(Hash2, Algorithms);
+
 // test that the hash values are consistent - i.e. asking for the same value returns the same result
-TEST_P(Hash2, HashesConsistent) {
+TYPED_TEST(Hash2, HashesConsistent) {
     std::vector<std::unordered_map<uint8_t, uint8_t>> hashes(SKETCH_DIM);
     for (uint32_t s = 0; s < SKETCH_DIM; ++s) {
-        for (uint32_t i = 0; i < hash_size; ++i) {
+        for (uint32_t i = 0; i < this->hash_size; ++i) {
             uint8_t v = this->hash(s, i);
             ASSERT_FALSE(hashes[s].find(i) != hashes[s].end());
             hashes[s][i] = v;
         }
-        ASSERT_EQ(hash_size, hashes[s].size());
+        ASSERT_EQ(this->hash_size, hashes[s].size());
     }
 
     for (uint32_t s = 0; s < SKETCH_DIM; ++s) {
-        for (uint32_t i = 0; i < hash_size; ++i) {
+        for (uint32_t i = 0; i < this->hash_size; ++i) {
             uint8_t v = this->hash(s, i);
             ASSERT_EQ(v, hashes[s][i]);
         }
     }
 }
 
-INSTANTIATE_TEST_SUITE_P(Method,
-                         Hash2,
-                         ::testing::Values(HashAlgorithm::uniform,
-                                           HashAlgorithm::crc32,
-                                           HashAlgorithm::murmur));
-
 } // namespace
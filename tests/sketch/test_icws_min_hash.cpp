@@ -0,0 +1,57 @@
+#include "sketch/hash_icws.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+namespace {
+
+using namespace ts;
+using namespace ::testing;
+
+TEST(ConsistentWeightedMinHash, Empty) {
+    ConsistentWeightedMinHash<uint8_t, HashAlgorithm::uniform> under_test(4 * 4 * 4, 3,
+                                                                          /*seed=*/31415);
+    std::vector<uint8_t> sketch = under_test.compute(std::vector<uint8_t>());
+    ASSERT_THAT(sketch, ElementsAre(0, 0, 0));
+}
+
+// the sketch depends only on the multiplicities of the k-mers, not on their order
+TEST(ConsistentWeightedMinHash, Permute) {
+    ConsistentWeightedMinHash<uint8_t, HashAlgorithm::uniform> under_test(4 * 4 * 4, 3,
+                                                                          /*seed=*/31415);
+    std::vector<uint8_t> sequence1 = { 0, 1, 1, 2, 3, 3, 3, 4, 5 };
+    std::vector<uint8_t> sequence2 = { 3, 5, 1, 4, 3, 2, 1, 0, 3 };
+    ASSERT_THAT(under_test.compute(sequence1), ElementsAreArray(under_test.compute(sequence2)));
+}
+
+// the fraction of equal components estimates the weighted Jaccard similarity
+TEST(ConsistentWeightedMinHash, EstimatesWeightedJaccard) {
+    constexpr size_t sketch_dim = 1024;
+    ConsistentWeightedMinHash<uint64_t> under_test(1UL << 20, sketch_dim, /*seed=*/31415);
+    // a contains k-mer s (1 + s%4) times for s in [0, 1000), b contains s twice for s in
+    // [500, 1500)
+    std::vector<uint64_t> weights_a(1500, 0), weights_b(1500, 0);
+    std::vector<uint64_t> a, b;
+    for (uint64_t s = 0; s < 1500; ++s) {
+        weights_a[s] = s < 1000 ? 1 + s % 4 : 0;
+        weights_b[s] = s >= 500 ? 2 : 0;
+        a.insert(a.end(), weights_a[s], s);
+        b.insert(b.end(), weights_b[s], s);
+    }
+    std::mt19937 gen(31415);
+    std::shuffle(a.begin(), a.end(), gen);
+    std::shuffle(b.begin(), b.end(), gen);
+    double sum_min = 0, sum_max = 0;
+    for (uint64_t s = 0; s < 1500; ++s) {
+        sum_min += std::min(weights_a[s], weights_b[s]);
+        sum_max += std::max(weights_a[s], weights_b[s]);
+    }
+    const double dist = ConsistentWeightedMinHash<uint64_t>::dist(under_test.compute(a),
+                                                                  under_test.compute(b));
+    ASSERT_NEAR(sum_min / sum_max, 1 - dist / sketch_dim, 0.05);
+}
+
+} // namespace
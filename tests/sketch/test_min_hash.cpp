@@ -12,13 +12,13 @@ using namespace ts;
 using namespace ::testing;
 
 TEST(MinHash, Empty) {
-    MinHash<uint8_t> under_test(4 * 4 * 4, 3, HashAlgorithm::uniform, /*seed=*/ 31415);
+    MinHash<uint8_t, HashAlgorithm::uniform> under_test(4 * 4 * 4, 3, /*seed=*/31415);
     std::vector<uint8_t> sketch = under_test.compute(std::vector<uint8_t>());
     ASSERT_THAT(sketch, ElementsAre(0, 0, 0));
 }
 
 TEST(MinHash, Repeat) {
-    MinHash<uint8_t> under_test(4 * 4 * 4, 3, HashAlgorithm::uniform, /*seed=*/ 31415);
+    MinHash<uint8_t, HashAlgorithm::uniform> under_test(4 * 4 * 4, 3, /*seed=*/31415);
     std::vector<uint8_t> sequence = { 0, 1, 2, 3, 4, 5 };
     std::vector<uint8_t> sketch1 = under_test.compute(sequence);
     std::vector<uint8_t> sketch2 = under_test.compute(sequence);
@@ -26,7 +26,7 @@ TEST(MinHash, Repeat) {
 }
 
 TEST(MinHash, Permute) {
-    MinHash<uint8_t> under_test(4 * 4 * 4, 3, HashAlgorithm::uniform, /*seed=*/ 31415);
+    MinHash<uint8_t, HashAlgorithm::uniform> under_test(4 * 4 * 4, 3, /*seed=*/31415);
     std::vector<uint8_t> sequence1 = { 0, 1, 2, 3, 4, 5 };
     std::vector<uint8_t> sequence2 = { 5, 4, 3, 2, 1, 0 };
     std::vector<uint8_t> sketch1 = under_test.compute(sequence1);
@@ -35,7 +35,7 @@ TEST(MinHash, Permute) {
 }
 
 TEST(MinHash, PermuteAndRepeat) {
-    MinHash<uint8_t> under_test(4 * 4 * 4, 3, HashAlgorithm::uniform, /*seed=*/ 31415);
+    MinHash<uint8_t, HashAlgorithm::uniform> under_test(4 * 4 * 4, 3, /*seed=*/31415);
     std::vector<uint8_t> sequence1 = { 0, 1, 2, 3, 4, 5 };
     std::vector<uint8_t> sequence2 = { 5, 5, 4, 4, 3, 3, 2, 2, 1, 1, 0, 0 };
     std::vector<uint8_t> sketch1 = under_test.compute(sequence1);
@@ -54,7 +54,7 @@ std::vector<std::unordered_map<uint8_t, uint8_t>> hash_init(uint32_t set_sz, uin
 }
 
 TEST(MinHash, PresetHash) {
-    MinHash<uint8_t> under_test(4 * 4, 3, HashAlgorithm::uniform, /*seed=*/ 31415);
+    MinHash<uint8_t, HashAlgorithm::uniform> under_test(4 * 4, 3, /*seed=*/31415);
     under_test.set_hashes_for_testing(hash_init(4 * 4, 3));
     for (uint32_t i = 0; i < 4 * 4; ++i) {
         std::vector<uint8_t> sequence(4 * 4 - i);
@@ -64,4 +64,34 @@ TEST(MinHash, PresetHash) {
     }
 }
 
+/** Exposes the scalar hash functions, to check the vectorized single pass of #compute */
+class Mix32MinHash : public MinHash<uint64_t, HashAlgorithm::mix32> {
+  public:
+    explicit Mix32MinHash(size_t sketch_dim) : MinHash(1UL << 40, sketch_dim, /*seed=*/31415) {}
+    using MinHash::hash;
+};
+
+TEST(MinHash, Mix32SameAsScalar) {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<uint64_t> rand_kmer(0, 1UL << 40);
+    for (size_t sketch_dim : { 1, 7, 16, 40, 100 }) {
+        Mix32MinHash under_test(sketch_dim);
+        std::vector<uint64_t> kmers(1000);
+        for (uint64_t &kmer : kmers) {
+            kmer = rand_kmer(gen);
+        }
+        std::vector<uint64_t> sketch = under_test.compute(kmers);
+        ASSERT_EQ(sketch_dim, sketch.size());
+        for (size_t si = 0; si < sketch_dim; ++si) {
+            uint64_t expected = kmers[0];
+            for (uint64_t kmer : kmers) {
+                if (under_test.hash(si, kmer) < under_test.hash(si, expected)) {
+                    expected = kmer;
+                }
+            }
+            ASSERT_EQ(expected, sketch[si]) << "sketch_dim=" << sketch_dim << " si=" << si;
+        }
+    }
+}
+
 } // namespace
@@ -0,0 +1,72 @@
+#include "sketch/multi_hash.hpp"
+#include "sketch/shift_sum.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ts;
+using namespace ::testing;
+
+class MultiHash : public testing::TestWithParam<SimdLevel> {
+  public:
+    void SetUp() override {
+        if (static_cast<int>(GetParam()) > static_cast<int>(detect_simd_level())) {
+            GTEST_SKIP() << "Instruction set not supported by this CPU";
+        }
+        set_simd_level_for_testing(GetParam());
+    }
+
+    void TearDown() override { set_simd_level_for_testing(detect_simd_level()); }
+};
+
+// the vectorized kernel must find the first minimum of every function, for any number of functions
+// (including numbers that are not a multiple of the vector width)
+TEST_P(MultiHash, SameAsNaive) {
+    std::mt19937 gen(31415);
+    for (size_t num_keys : { 1, 5, 300 }) {
+        // few distinct keys, so that the minima are repeated
+        std::uniform_int_distribution<uint32_t> rand_key(0, num_keys / 2);
+        std::vector<uint32_t> keys(num_keys);
+        for (uint32_t &key : keys) {
+            key = rand_key(gen);
+        }
+        for (size_t num_functions = 1; num_functions < 150; num_functions += 7) {
+            std::vector<uint32_t> a(num_functions), b(num_functions);
+            for (size_t k = 0; k < num_functions; ++k) {
+                a[k] = gen() | 1;
+                b[k] = gen();
+            }
+            std::vector<uint32_t> argmin(num_functions);
+            min_hash_mix32(keys.data(), num_keys, a.data(), b.data(), num_functions,
+                           argmin.data());
+            for (size_t k = 0; k < num_functions; ++k) {
+                uint32_t expected = 0;
+                for (uint32_t i = 1; i < num_keys; ++i) {
+                    if (mix32(keys[i], a[k], b[k]) < mix32(keys[expected], a[k], b[k])) {
+                        expected = i;
+                    }
+                }
+                ASSERT_EQ(expected, argmin[k])
+                        << "keys=" << num_keys << " functions=" << num_functions << " k=" << k;
+            }
+        }
+    }
+}
+
+// keys below 2^32 are not changed by the folding, so they can't collide
+TEST(MultiHash, FoldKeepsSmallKeys) {
+    for (uint64_t key : { 0UL, 1UL, 12345UL, 0xffffffffUL }) {
+        ASSERT_EQ(key, fold32(key));
+    }
+    ASSERT_NE(fold32(1UL << 32), fold32(0));
+}
+
+INSTANTIATE_TEST_SUITE_P(Method,
+                         MultiHash,
+                         ::testing::Values(SimdLevel::scalar, SimdLevel::avx2, SimdLevel::avx512));
+
+} // namespace
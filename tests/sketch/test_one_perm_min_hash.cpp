@@ -0,0 +1,58 @@
+#include "sketch/hash_one_perm.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_set>
+
+namespace {
+
+using namespace ts;
+using namespace ::testing;
+
+TEST(OnePermMinHash, Empty) {
+    OnePermMinHash<uint8_t, HashAlgorithm::uniform> under_test(4 * 4 * 4, 3, /*seed=*/31415);
+    std::vector<uint8_t> sketch = under_test.compute(std::vector<uint8_t>());
+    ASSERT_THAT(sketch, ElementsAre(0, 0, 0));
+}
+
+TEST(OnePermMinHash, PermuteAndRepeat) {
+    OnePermMinHash<uint8_t, HashAlgorithm::uniform> under_test(4 * 4 * 4, 3, /*seed=*/31415);
+    std::vector<uint8_t> sequence1 = { 0, 1, 2, 3, 4, 5 };
+    std::vector<uint8_t> sequence2 = { 5, 5, 4, 4, 3, 3, 2, 2, 1, 1, 0, 0 };
+    std::vector<uint8_t> sketch1 = under_test.compute(sequence1);
+    std::vector<uint8_t> sketch2 = under_test.compute(sequence2);
+    ASSERT_THAT(sketch1, ElementsAreArray(sketch2));
+}
+
+// with far fewer k-mers than bins, most bins are densified, and must contain one of the k-mers
+TEST(OnePermMinHash, Densified) {
+    OnePermMinHash<uint64_t> under_test(1UL << 20, 1024, /*seed=*/31415);
+    std::vector<uint64_t> kmers = { 17, 123456, 42 };
+    std::vector<uint64_t> sketch = under_test.compute(kmers);
+    ASSERT_EQ(1024, sketch.size());
+    for (uint64_t value : sketch) {
+        ASSERT_THAT(kmers, Contains(value));
+    }
+    // every k-mer has its own bin, unless two of them collide
+    ASSERT_EQ(kmers.size(), std::unordered_set<uint64_t>(sketch.begin(), sketch.end()).size());
+}
+
+// the fraction of equal bins estimates the Jaccard similarity of the k-mer sets, both when most
+// bins are filled by hashing and when most are densified
+TEST(OnePermMinHash, EstimatesJaccard) {
+    for (size_t num_kmers : { 20000, 400 }) {
+        OnePermMinHash<uint64_t> under_test(1UL << 20, 1024, /*seed=*/31415);
+        // a and b share half of their k-mers, so the Jaccard similarity is 1/3
+        std::vector<uint64_t> a(num_kmers), b(num_kmers);
+        std::iota(a.begin(), a.end(), 0);
+        std::iota(b.begin(), b.end(), num_kmers / 2);
+        const double dist = OnePermMinHash<uint64_t>::dist(under_test.compute(a),
+                                                           under_test.compute(b));
+        ASSERT_NEAR(1.0 / 3, 1 - dist / 1024, 0.05) << "num_kmers=" << num_kmers;
+    }
+}
+
+} // namespace
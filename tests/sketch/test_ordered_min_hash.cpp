@@ -17,14 +17,16 @@ constexpr uint32_t tuple_length = 3;
 constexpr uint32_t max_sequence_len = 200;
 
 TEST(OrderedMinHash, Empty) {
-    OrderedMinHash<uint8_t> under_test(set_size, sketch_dim, max_sequence_len, tuple_length,
-                                       HashAlgorithm::uniform, /*seed=*/31415);
+    OrderedMinHash<uint8_t, HashAlgorithm::uniform> under_test(set_size, sketch_dim,
+                                                               max_sequence_len, tuple_length,
+                                                               /*seed=*/31415);
     ASSERT_THROW(under_test.compute(std::vector<uint8_t>()), std::invalid_argument);
 }
 
 TEST(OrderedMinHash, Repeat) {
-    OrderedMinHash<uint8_t> under_test(set_size, sketch_dim, max_sequence_len, tuple_length,
-                                       HashAlgorithm::uniform, /*seed=*/31415);
+    OrderedMinHash<uint8_t, HashAlgorithm::uniform> under_test(set_size, sketch_dim,
+                                                               max_sequence_len, tuple_length,
+                                                               /*seed=*/31415);
     std::vector<uint8_t> sequence = { 0, 1, 2, 3, 4, 5 };
     Vec2D<uint8_t> sketch1 = under_test.compute_2d(sequence);
     Vec2D<uint8_t> sketch2 = under_test.compute_2d(sequence);
@@ -36,8 +38,9 @@ TEST(OrderedMinHash, Repeat) {
 }
 
 TEST(OrderedMinHash, ReverseOrder) {
-    OrderedMinHash<uint8_t> under_test(set_size, sketch_dim, max_sequence_len, tuple_length,
-                                       HashAlgorithm::uniform, /*seed=*/31415);
+    OrderedMinHash<uint8_t, HashAlgorithm::uniform> under_test(set_size, sketch_dim,
+                                                               max_sequence_len, tuple_length,
+                                                               /*seed=*/31415);
     std::vector<uint8_t> sequence1 = { 0, 1, 2, 3, 4, 5 };
     std::vector<uint8_t> sequence2 = { 5, 4, 3, 2, 1, 0 };
     Vec2D<uint8_t> sketch1 = under_test.compute_2d(sequence1);
@@ -62,8 +65,9 @@ hash_init(uint32_t set_sz, uint32_t sketch_size, uint32_t max_seq_len) {
 }
 
 TEST(OrderedMinHash, PresetHash) {
-    OrderedMinHash<uint8_t> under_test(set_size, sketch_dim, max_sequence_len, tuple_length,
-                                       HashAlgorithm::uniform, /*seed=*/31415);
+    OrderedMinHash<uint8_t, HashAlgorithm::uniform> under_test(set_size, sketch_dim,
+                                                               max_sequence_len, tuple_length,
+                                                               /*seed=*/31415);
     under_test.set_hashes_for_testing(hash_init(set_size, sketch_dim, max_sequence_len));
     for (uint32_t i = 0; i < set_size - tuple_length; ++i) {
         std::vector<uint8_t> sequence(set_size - i);
@@ -76,8 +80,9 @@ TEST(OrderedMinHash, PresetHash) {
 }
 
 TEST(OrderedMinHash, PresetHashRepeat) {
-    OrderedMinHash<uint8_t> under_test(set_size, sketch_dim, max_sequence_len, tuple_length,
-                                       HashAlgorithm::uniform, /*seed=*/ 31415);
+    OrderedMinHash<uint8_t, HashAlgorithm::uniform> under_test(set_size, sketch_dim,
+                                                               max_sequence_len, tuple_length,
+                                                               /*seed=*/31415);
     under_test.set_hashes_for_testing(hash_init(set_size, sketch_dim, max_sequence_len));
     for (uint32_t i = 0; i < set_size - tuple_length; ++i) {
         std::vector<uint8_t> sequence(2 * (set_size - i));
@@ -92,8 +97,9 @@ TEST(OrderedMinHash, PresetHashRepeat) {
 
 #ifndef NDEBUG
 TEST(OrderedMinhash, SequenceTooLong) {
-    OrderedMinHash<uint8_t> under_test(set_size, sketch_dim, max_sequence_len, tuple_length,
-                                       HashAlgorithm::uniform, /*seed=*/ 31415);
+    OrderedMinHash<uint8_t, HashAlgorithm::uniform> under_test(set_size, sketch_dim,
+                                                               max_sequence_len, tuple_length,
+                                                               /*seed=*/31415);
     std::vector<uint8_t> sequence(max_sequence_len + 1);
     ASSERT_THROW(under_test.compute(sequence), std::invalid_argument);
 }
@@ -0,0 +1,116 @@
+#include "sketch/shift_sum.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace ts;
+using namespace ::testing;
+
+class ShiftSum : public testing::TestWithParam<SimdLevel> {
+  public:
+    void SetUp() override {
+        if (static_cast<int>(GetParam()) > static_cast<int>(detect_simd_level())) {
+            GTEST_SKIP() << "Instruction set not supported by this CPU";
+        }
+        set_simd_level_for_testing(GetParam());
+    }
+
+    void TearDown() override { set_simd_level_for_testing(detect_simd_level()); }
+};
+
+// the vectorized kernel must match the naive formula for all lengths (including lengths that are
+// not a multiple of the vector width) and all shifts
+TEST_P(ShiftSum, SameAsNaive) {
+    std::mt19937 gen(31415);
+    std::uniform_real_distribution<double> rand_val(0, 1);
+    for (size_t len = 1; len < 40; ++len) {
+        for (size_t shift = 0; shift < len; ++shift) {
+            std::vector<double> a(len), b(len);
+            for (size_t i = 0; i < len; ++i) {
+                a[i] = rand_val(gen);
+                b[i] = rand_val(gen);
+            }
+            const double z = rand_val(gen);
+            std::vector<double> expected(len);
+            for (size_t i = 0; i < len; ++i) {
+                expected[i] = (1 - z) * a[i] + z * b[(len + i - shift) % len];
+            }
+            shift_sum(a.data(), a.data(), b.data(), len, shift, z);
+            for (size_t i = 0; i < len; ++i) {
+                ASSERT_NEAR(expected[i], a[i], 1e-12) << "len=" << len << " shift=" << shift;
+            }
+        }
+    }
+}
+
+// every lane of the interleaved kernel must match the naive formula with its own shift and weights
+TEST_P(ShiftSum, LanesSameAsNaive) {
+    constexpr size_t L = kBatchLanes;
+    std::mt19937 gen(31415);
+    std::uniform_real_distribution<double> rand_val(0, 1);
+    for (size_t len = 1; len < 40; ++len) {
+        std::uniform_int_distribution<uint32_t> rand_shift(0, len - 1);
+        std::vector<double> a(len * L), b(len * L);
+        for (size_t i = 0; i < len * L; ++i) {
+            a[i] = rand_val(gen);
+            b[i] = rand_val(gen);
+        }
+        uint32_t shift[L];
+        double keep[L], w[L];
+        for (size_t l = 0; l < L; ++l) {
+            shift[l] = rand_shift(gen);
+            keep[l] = rand_val(gen);
+            w[l] = rand_val(gen);
+        }
+        std::vector<double> expected(len * L);
+        for (size_t i = 0; i < len; ++i) {
+            for (size_t l = 0; l < L; ++l) {
+                expected[i * L + l] = keep[l] * a[i * L + l]
+                        + w[l] * b[((len + i - shift[l]) % len) * L + l];
+            }
+        }
+        shift_sum_lanes(a.data(), b.data(), len, shift, keep, w);
+        for (size_t i = 0; i < len * L; ++i) {
+            ASSERT_NEAR(expected[i], a[i], 1e-12) << "len=" << len << " i=" << i;
+        }
+    }
+}
+
+// the count kernel must match the naive formula for all lengths and shifts, in both directions
+TEST_P(ShiftSum, AddSameAsNaive) {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<int64_t> rand_val(-1000, 1000);
+    for (size_t len = 1; len < 40; ++len) {
+        for (size_t shift = 0; shift < len; ++shift) {
+            for (bool negate : { false, true }) {
+                std::vector<int64_t> a(len), b(len);
+                for (size_t i = 0; i < len; ++i) {
+                    a[i] = rand_val(gen);
+                    b[i] = rand_val(gen);
+                }
+                std::vector<int64_t> expected(len);
+                for (size_t i = 0; i < len; ++i) {
+                    const int64_t v = b[(len + i - shift) % len];
+                    expected[i] = negate ? a[i] - v : a[i] + v;
+                }
+                shift_add(a.data(), b.data(), len, shift, negate);
+                ASSERT_EQ(expected, a) << "len=" << len << " shift=" << shift;
+
+                std::vector<double> ad(a.begin(), a.end()), bd(b.begin(), b.end());
+                shift_add(ad.data(), bd.data(), len, shift, negate);
+                shift_add(a.data(), b.data(), len, shift, negate);
+                ASSERT_EQ(std::vector<double>(a.begin(), a.end()), ad);
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Method,
+                         ShiftSum,
+                         ::testing::Values(SimdLevel::scalar, SimdLevel::avx2, SimdLevel::avx512));
+
+} // namespace
@@ -192,4 +192,179 @@ TEST(Tensor, DistinctCharsTupleTMinus1) {
     }
 }
 
+/**
+ * The state buffer is shared by all Tensor objects on a thread, so alternating between sketchers of
+ * different dimensions must give the same results as running each of them on its own.
+ */
+TEST(Tensor, ReusedWorkspace) {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size - 1);
+    std::vector<uint8_t> sequence(100);
+    std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(gen); });
+
+    Tensor<uint8_t> small(alphabet_size, 3, 2, /*seed=*/31415);
+    Tensor<uint8_t> large(alphabet_size, 17, 5, /*seed=*/31415);
+    std::vector<double> small_sketch = small.compute(sequence);
+    std::vector<double> large_sketch = large.compute(sequence);
+    for (uint32_t rep = 0; rep < 3; ++rep) {
+        ASSERT_THAT(small.compute(sequence), ElementsAreArray(small_sketch));
+        ASSERT_THAT(large.compute(sequence), ElementsAreArray(large_sketch));
+    }
+}
+
+/**
+ * Sketching a batch of packed sequences must give the same result as sketching each sequence on its
+ * own, including for batches that don't fill all lanes and for sequences shorter than t.
+ */
+TEST(Tensor, BatchSameAsSingle) {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size - 1);
+    std::uniform_int_distribution<uint32_t> rand_len(0, 60);
+    for (uint32_t sketch_dimension : { 1, 3, 4, 16, 33 }) {
+        Tensor<uint8_t> under_test(alphabet_size, sketch_dimension, tuple_length, /*seed=*/31415);
+        for (uint32_t num_seqs : { 0, 1, 7, 8, 21 }) {
+            Vec2D<uint8_t> seqs(num_seqs);
+            std::vector<uint8_t> packed;
+            std::vector<size_t> starts = { 0 };
+            for (auto &seq : seqs) {
+                seq.resize(rand_len(gen));
+                std::generate(seq.begin(), seq.end(), [&]() { return rand_char(gen); });
+                packed.insert(packed.end(), seq.begin(), seq.end());
+                starts.push_back(packed.size());
+            }
+            std::vector<double> sketches = under_test.compute_batch(packed, starts);
+            ASSERT_EQ(num_seqs * sketch_dimension, sketches.size());
+            for (uint32_t j = 0; j < num_seqs; ++j) {
+                std::vector<double> sketch = under_test.compute(seqs[j]);
+                for (uint32_t i = 0; i < sketch_dimension; ++i) {
+                    ASSERT_NEAR(sketch[i], sketches[j * sketch_dimension + i], 1e-12)
+                            << "D=" << sketch_dimension << " seq=" << j;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * The single precision sketch must stay close to the double precision one. The state is a convex
+ * combination of values in [0,1] at each step, so rounding errors don't compound beyond a small
+ * multiple of the float epsilon, even for long sequences.
+ */
+TEST(Tensor, FloatCloseToDouble) {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size - 1);
+    for (uint32_t sequence_length : { 10, 100, 1000, 10000 }) {
+        std::vector<uint8_t> sequence(sequence_length);
+        std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(gen); });
+        for (uint32_t sketch_dimension : { 3, 16, 64 }) {
+            for (uint32_t tuple_len : { 1, 3, 6 }) {
+                Tensor<uint8_t> sketcher(alphabet_size, sketch_dimension, tuple_len, 31415);
+                Tensor<uint8_t, float> sketcher_float(alphabet_size, sketch_dimension, tuple_len,
+                                                      31415);
+                std::vector<double> sketch = sketcher.compute(sequence);
+                std::vector<float> sketch_float = sketcher_float.compute(sequence);
+                ASSERT_EQ(sketch.size(), sketch_float.size());
+                for (uint32_t i = 0; i < sketch_dimension; ++i) {
+                    ASSERT_NEAR(sketch[i], sketch_float[i], 1e-5)
+                            << "n=" << sequence_length << " D=" << sketch_dimension
+                            << " t=" << tuple_len;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Sketching a sequence in chunks and merging the partial states must give the same result as
+ * sketching it in one go, including when chunks are shorter than t or empty.
+ */
+TEST(Tensor, ParallelSameAsSingle) {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size - 1);
+    std::uniform_int_distribution<uint32_t> rand_len(0, 200);
+    for (uint32_t sketch_dimension : { 1, 3, 16, 33 }) {
+        for (uint32_t tuple_len : { 1, 3, 5 }) {
+            Tensor<uint8_t> under_test(alphabet_size, sketch_dimension, tuple_len, 31415);
+            for (uint32_t num_chunks : { 1, 2, 3, 7, 300 }) {
+                std::vector<uint8_t> sequence(rand_len(gen));
+                std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(gen); });
+                std::vector<double> sketch = under_test.compute(sequence);
+                std::vector<double> parallel_sketch
+                        = under_test.compute_parallel(sequence, num_chunks);
+                ASSERT_EQ(sketch.size(), parallel_sketch.size());
+                for (uint32_t i = 0; i < sketch_dimension; ++i) {
+                    ASSERT_NEAR(sketch[i], parallel_sketch[i], 1e-12)
+                            << "D=" << sketch_dimension << " t=" << tuple_len
+                            << " chunks=" << num_chunks << " n=" << sequence.size();
+                }
+            }
+        }
+    }
+}
+
+/**
+ * The count mode must compute the same sketches as the normalized recurrence, both when the counts
+ * fit in an int64 and when they are accumulated in double.
+ */
+TEST(Tensor, CountModeSameAsNormalized) {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size - 1);
+    for (uint32_t sketch_dimension : { 1, 3, 16, 33 }) {
+        // for t=12, binomial(1000, 12) exceeds 2^62 and the counts are accumulated in double
+        for (uint32_t tuple_len : { 1, 3, 5, 12 }) {
+            Tensor<uint8_t> normalized(alphabet_size, sketch_dimension, tuple_len, 31415);
+            Tensor<uint8_t> counts(alphabet_size, sketch_dimension, tuple_len, 31415, "TS", true);
+            for (uint32_t len : { 0, 1, 3, 12, 100, 1000 }) {
+                std::vector<uint8_t> sequence(len);
+                std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(gen); });
+                std::vector<double> sketch = normalized.compute(sequence);
+                std::vector<double> count_sketch = counts.compute(sequence);
+                ASSERT_EQ(sketch.size(), count_sketch.size());
+                for (uint32_t i = 0; i < sketch_dimension; ++i) {
+                    ASSERT_NEAR(sketch[i], count_sketch[i], 1e-12)
+                            << "D=" << sketch_dimension << " t=" << tuple_len << " len=" << len;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * The sketch of order p computed by #compute_all_orders must be the same as the one of a Tensor with
+ * subsequence_len=p and the same seed, which uses the same first p hash functions.
+ */
+TEST(Tensor, AllOrdersSameAsSeparateRuns) {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size - 1);
+    std::uniform_int_distribution<uint32_t> rand_len(0, 200);
+    constexpr uint32_t max_order = 5;
+    for (uint32_t sketch_dimension : { 1, 3, 16 }) {
+        Tensor<uint8_t> under_test(alphabet_size, sketch_dimension, max_order, /*seed=*/31415);
+        for (uint32_t trial = 0; trial < 5; ++trial) {
+            std::vector<uint8_t> seq1(rand_len(gen)), seq2(rand_len(gen));
+            std::generate(seq1.begin(), seq1.end(), [&]() { return rand_char(gen); });
+            std::generate(seq2.begin(), seq2.end(), [&]() { return rand_char(gen); });
+            Vec2D<double> sketches1 = under_test.compute_all_orders(seq1);
+            Vec2D<double> sketches2 = under_test.compute_all_orders(seq2);
+            ASSERT_EQ(max_order, sketches1.size());
+
+            double total_dist = 0;
+            std::vector<double> dists = Tensor<uint8_t>::dist_per_order(sketches1, sketches2);
+            for (uint32_t p = 1; p <= max_order; ++p) {
+                Tensor<uint8_t> single_order(alphabet_size, sketch_dimension, p, /*seed=*/31415);
+                std::vector<double> sketch1 = single_order.compute(seq1);
+                std::vector<double> sketch2 = single_order.compute(seq2);
+                ASSERT_EQ(sketch_dimension, sketches1[p - 1].size());
+                for (uint32_t i = 0; i < sketch_dimension; ++i) {
+                    ASSERT_NEAR(sketch1[i], sketches1[p - 1][i], 1e-12);
+                    ASSERT_NEAR(sketch2[i], sketches2[p - 1][i], 1e-12);
+                }
+                ASSERT_NEAR(Tensor<uint8_t>::dist(sketch1, sketch2), dists[p - 1], 1e-12);
+                total_dist += dists[p - 1];
+            }
+            ASSERT_NEAR(total_dist, Tensor<uint8_t>::dist_all_orders(sketches1, sketches2), 1e-12);
+        }
+    }
+}
+
 } // namespace
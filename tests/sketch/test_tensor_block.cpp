@@ -6,6 +6,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <random>
+
 namespace {
 
 using namespace ts;
@@ -222,4 +224,50 @@ TEST(TensorBlock, SameAsTensorSketchForBlockSizeOne) {
     }
 }
 
+/**
+ * The combined block hashes are tabulated for small alphabets and computed character by character
+ * for large ones; both must give the same sketches.
+ */
+TEST(TensorBlock, TabulatedSameAsLarge) {
+    std::mt19937 gen(31415);
+    constexpr uint8_t large_alphabet = 200; // too many blocks of size 2 to tabulate
+    std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size - 1);
+    for (uint32_t block_size : { 2, 3 }) {
+        constexpr uint32_t sketch_dimension = 16;
+        const uint32_t tuple_len = 2 * block_size;
+        TensorBlock<uint8_t> large(large_alphabet, sketch_dimension, tuple_len, block_size,
+                                   /*seed=*/31415);
+        Vec2D<uint8_t> hashes = new2D<uint8_t>(tuple_len, large_alphabet);
+        Vec2D<bool> signs = new2D<bool>(tuple_len, large_alphabet);
+        std::uniform_int_distribution<uint8_t> rand_hash(0, sketch_dimension - 1);
+        for (uint32_t h = 0; h < tuple_len; ++h) {
+            for (uint32_t c = 0; c < large_alphabet; ++c) {
+                hashes[h][c] = rand_hash(gen);
+                signs[h][c] = rand_hash(gen) % 2;
+            }
+        }
+        large.set_hashes_for_testing(hashes, signs);
+
+        // the same hash functions, restricted to the first alphabet_size characters
+        TensorBlock<uint8_t> small(alphabet_size, sketch_dimension, tuple_len, block_size,
+                                   /*seed=*/31415);
+        Vec2D<uint8_t> small_hashes = new2D<uint8_t>(tuple_len, alphabet_size);
+        Vec2D<bool> small_signs = new2D<bool>(tuple_len, alphabet_size);
+        for (uint32_t h = 0; h < tuple_len; ++h) {
+            for (uint32_t c = 0; c < alphabet_size; ++c) {
+                small_hashes[h][c] = hashes[h][c];
+                small_signs[h][c] = signs[h][c];
+            }
+        }
+        small.set_hashes_for_testing(small_hashes, small_signs);
+
+        for (uint32_t len : { 0, 1, 5, 100 }) {
+            std::vector<uint8_t> sequence(len);
+            std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(gen); });
+            ASSERT_EQ(large.compute(sequence), small.compute(sequence))
+                    << "k=" << block_size << " len=" << len;
+        }
+    }
+}
+
 } // namespace
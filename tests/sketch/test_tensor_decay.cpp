@@ -0,0 +1,81 @@
+#include "sketch/tensor_decay.hpp"
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <random>
+#include <sstream>
+
+namespace {
+
+using namespace ts;
+using namespace ::testing;
+
+constexpr uint8_t alphabet_size = 4;
+constexpr uint32_t sketch_dim = 16;
+constexpr uint32_t window_length = 32;
+constexpr uint32_t stride = 4;
+
+std::vector<uint8_t> rand_sequence(uint32_t len, std::mt19937 *gen) {
+    std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size - 1);
+    std::vector<uint8_t> sequence(len);
+    std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(*gen); });
+    return sequence;
+}
+
+/** Until the window is full, the decayed sketch is the tensor sketch of the prefix */
+TEST(TensorDecay, SameAsTensorInFirstWindow) {
+    std::mt19937 gen(31415);
+    for (uint32_t tuple_len : { 1, 3, 6 }) {
+        Tensor<uint8_t> tensor(alphabet_size, sketch_dim, tuple_len, /*seed=*/31415);
+        TensorDecay<uint8_t> under_test(alphabet_size, sketch_dim, tuple_len, window_length, stride,
+                                        /*seed=*/31415);
+        const std::vector<uint8_t> sequence = rand_sequence(100, &gen);
+        Vec2D<double> sketches = under_test.compute(sequence);
+        ASSERT_EQ(sequence.size() / stride, sketches.size());
+        for (uint32_t i = 0; (i + 1) * stride <= window_length + 1; ++i) {
+            std::vector<uint8_t> prefix(sequence.begin(), sequence.begin() + (i + 1) * stride);
+            std::vector<double> sketch = tensor.compute(prefix);
+            for (uint32_t j = 0; j < sketch_dim; ++j) {
+                ASSERT_NEAR(sketch[j], sketches[i][j], 1e-12) << "t=" << tuple_len << " i=" << i;
+            }
+        }
+    }
+}
+
+/** Two sequences that end with the same long suffix must have almost the same last sketch */
+TEST(TensorDecay, ForgetsOldCharacters) {
+    std::mt19937 gen(31415);
+    TensorDecay<uint8_t> under_test(alphabet_size, sketch_dim, 3, window_length, stride,
+                                    /*seed=*/31415);
+    const std::vector<uint8_t> suffix = rand_sequence(40 * window_length, &gen);
+    std::vector<uint8_t> a = rand_sequence(100, &gen);
+    std::vector<uint8_t> b = rand_sequence(100, &gen);
+    a.insert(a.end(), suffix.begin(), suffix.end());
+    b.insert(b.end(), suffix.begin(), suffix.end());
+    Vec2D<double> sketches_a = under_test.compute(a);
+    Vec2D<double> sketches_b = under_test.compute(b);
+    ASSERT_GT(l2_dist(sketches_a[0], sketches_b[0]), 1e-3);
+    ASSERT_LT(l2_dist(sketches_a.back(), sketches_b.back()), 1e-12);
+}
+
+/** Sketching a stream character by character gives the same sketches as sketching a vector */
+TEST(TensorDecay, StreamSameAsCompute) {
+    std::mt19937 gen(31415);
+    TensorDecay<uint8_t> under_test(alphabet_size, sketch_dim, 3, window_length, stride,
+                                    /*seed=*/31415);
+    const std::vector<uint8_t> sequence = rand_sequence(1000, &gen);
+    Vec2D<double> sketches = under_test.compute(sequence);
+
+    std::istringstream in(std::string(sequence.begin(), sequence.end()));
+    size_t num_sketches = 0;
+    under_test.compute(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>(),
+                       [&](size_t index, const std::vector<double> &sketch) {
+                           ASSERT_EQ(num_sketches, index);
+                           ASSERT_EQ(sketches[index], sketch);
+                           num_sketches++;
+                       });
+    ASSERT_EQ(sketches.size(), num_sketches);
+}
+
+} // namespace
@@ -0,0 +1,73 @@
+#include "sketch/tensor_embedding.hpp"
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <random>
+
+namespace {
+
+using namespace ts;
+using namespace ::testing;
+
+/** Counts the subsequences of length t of #seq by enumerating all their positions */
+std::vector<double> naive_counts(const std::vector<uint8_t> &seq,
+                                 uint8_t alphabet_size,
+                                 uint32_t t) {
+    std::vector<uint8_t> valid;
+    for (uint8_t c : seq) {
+        if (c < alphabet_size) {
+            valid.push_back(c);
+        }
+    }
+    std::vector<double> counts(int_pow<size_t>(alphabet_size, t), 0);
+    std::vector<size_t> pos(t);
+    std::function<void(uint32_t, size_t, size_t)> enumerate = [&](uint32_t i, size_t from,
+                                                                  size_t index) {
+        if (i == t) {
+            counts[index]++;
+            return;
+        }
+        for (size_t j = from; j < valid.size(); ++j) {
+            enumerate(i + 1, j + 1, index * alphabet_size + valid[j]);
+        }
+    };
+    enumerate(0, 0, 0);
+    return counts;
+}
+
+TEST(TensorEmbedding, SameAsNaive) {
+    std::mt19937 gen(31415);
+    for (uint8_t alphabet_size : { 2, 4, 5 }) {
+        // include some characters outside the alphabet, which must be skipped
+        std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size);
+        for (uint32_t t : { 1, 2, 3, 4 }) {
+            TensorEmbedding<uint8_t> under_test(alphabet_size, t, "TE", /*normalize=*/false);
+            std::vector<uint8_t> sequence(20);
+            std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(gen); });
+            ASSERT_EQ(naive_counts(sequence, alphabet_size, t), under_test.compute(sequence))
+                    << "alphabet=" << (int)alphabet_size << " t=" << t;
+        }
+    }
+}
+
+/** The counts of the chunks are joined exactly as long as they stay below 2^53 */
+TEST(TensorEmbedding, ParallelSameAsSingle) {
+    std::mt19937 gen(31415);
+    for (uint8_t alphabet_size : { 4, 20 }) {
+        std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size);
+        for (uint32_t t : { 1, 2, 3 }) {
+            TensorEmbedding<uint8_t> under_test(alphabet_size, t);
+            std::vector<uint8_t> sequence(500);
+            std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(gen); });
+            const std::vector<double> expected = under_test.compute(sequence);
+            for (size_t num_chunks : { 1, 2, 3, 7, 500 }) {
+                ASSERT_EQ(expected, under_test.compute_parallel(sequence, num_chunks))
+                        << "alphabet=" << (int)alphabet_size << " t=" << t
+                        << " chunks=" << num_chunks;
+            }
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,77 @@
+#include "sketch/tensor_embedding.hpp"
+#include "sketch/tensor_embedding_sparse.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <numeric>
+#include <random>
+
+namespace {
+
+using namespace ts;
+using namespace ::testing;
+
+std::vector<double> to_dense(const SparseVec &sparse, size_t size) {
+    std::vector<double> dense(size, 0);
+    for (const auto &[index, value] : sparse) {
+        dense.at(index) = value;
+    }
+    return dense;
+}
+
+/**
+ * The sparse embedding must contain exactly the non-zero entries of the dense one, both for small
+ * alphabets, where the counts become dense, and for large ones, where they stay sparse
+ */
+TEST(TensorEmbeddingSparse, SameAsDense) {
+    std::mt19937 gen(31415);
+    for (uint8_t alphabet_size : { 4, 20 }) {
+        // include some characters outside the alphabet, which must be skipped
+        std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size);
+        for (uint32_t t : { 1, 2, 3, 4 }) {
+            TensorEmbedding<uint8_t> dense(alphabet_size, t);
+            TensorEmbeddingSparse<uint8_t> sparse(alphabet_size, t);
+            std::vector<double> prev_dense;
+            SparseVec prev_sparse;
+            for (uint32_t len : { 0, 1, 5, 50, 300 }) {
+                std::vector<uint8_t> sequence(len);
+                std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(gen); });
+                std::vector<double> expected = dense.compute(sequence);
+                SparseVec actual = sparse.compute(sequence);
+                if (std::isnan(expected[0])) { // fewer than t characters, there are no tuples
+                    ASSERT_TRUE(actual.empty());
+                    continue;
+                }
+                for (const auto &entry : actual) {
+                    ASSERT_NE(0, entry.second);
+                }
+                ASSERT_EQ(expected, to_dense(actual, expected.size()))
+                        << "alphabet=" << (int)alphabet_size << " t=" << t << " len=" << len;
+                if (!prev_dense.empty()) {
+                    ASSERT_EQ(TensorEmbedding<uint8_t>::dist(expected, prev_dense),
+                              TensorEmbeddingSparse<uint8_t>::dist(actual, prev_sparse));
+                }
+                prev_dense = expected;
+                prev_sparse = actual;
+            }
+        }
+    }
+}
+
+/** Protein alphabet with long tuples, for which the dense tensor would have 20^8 entries */
+TEST(TensorEmbeddingSparse, LongTuples) {
+    TensorEmbeddingSparse<uint8_t> sparse(20, 8, "TensorSparse", /*normalize=*/false);
+    std::vector<uint8_t> sequence(12);
+    std::iota(sequence.begin(), sequence.end(), 0);
+    SparseVec embedding = sparse.compute(sequence);
+    // all characters are distinct, so each of the C(12,8) subsequences occurs once
+    ASSERT_EQ(495, embedding.size());
+    for (const auto &entry : embedding) {
+        ASSERT_EQ(1, entry.second);
+    }
+    ASSERT_EQ(0, TensorEmbeddingSparse<uint8_t>::dist(embedding, embedding));
+    ASSERT_EQ(495, TensorEmbeddingSparse<uint8_t>::dist(embedding, SparseVec()));
+}
+
+} // namespace
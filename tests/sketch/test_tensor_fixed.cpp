@@ -0,0 +1,48 @@
+#include "sketch/tensor_fixed.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace {
+
+using namespace ts;
+using namespace ::testing;
+
+constexpr uint8_t alphabet_size = 4;
+
+/** Checks that TensorFixed<t, D> and Tensor with the same seed compute the same sketches */
+template <uint32_t t, uint32_t D, class scalar_type = double>
+void check_same_as_tensor(double max_error) {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size - 1);
+    Tensor<uint8_t, scalar_type> tensor(alphabet_size, D, t, /*seed=*/31415);
+    TensorFixed<uint8_t, t, D, scalar_type> tensor_fixed(alphabet_size, /*seed=*/31415);
+    // also covers sequences shorter than t, for which only some of the rows are updated
+    for (uint32_t len : { 0, 1, 2, 3, 10, 100, 1000 }) {
+        std::vector<uint8_t> sequence(len);
+        std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(gen); });
+        std::vector<scalar_type> sketch = tensor.compute(sequence);
+        std::vector<scalar_type> sketch_fixed = tensor_fixed.compute(sequence);
+        ASSERT_EQ(D, sketch_fixed.size());
+        for (uint32_t i = 0; i < D; ++i) {
+            ASSERT_NEAR(sketch[i], sketch_fixed[i], max_error)
+                    << "t=" << t << " D=" << D << " len=" << len;
+        }
+    }
+}
+
+TEST(TensorFixed, SameAsTensor) {
+    check_same_as_tensor<3, 4>(1e-12);
+    check_same_as_tensor<3, 16>(1e-12);
+    check_same_as_tensor<3, 64>(1e-12);
+    check_same_as_tensor<1, 5>(1e-12);
+    check_same_as_tensor<6, 33>(1e-12);
+}
+
+TEST(TensorFixed, SameAsTensorFloat) {
+    check_same_as_tensor<3, 4, float>(1e-6);
+    check_same_as_tensor<3, 64, float>(1e-6);
+}
+
+} // namespace
@@ -0,0 +1,86 @@
+#include "sketch/tensor.hpp"
+#include "sketch/tensor_multi.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace {
+
+using namespace ts;
+using namespace ::testing;
+
+constexpr uint8_t alphabet_size = 4;
+constexpr uint32_t tuple_length = 3;
+constexpr uint32_t num_repetitions = 5;
+
+template <typename set_type>
+void rand_init(uint32_t sketch_size, Vec3D<set_type> *hashes, Vec3D<bool> *signs) {
+    std::mt19937 gen(3412343);
+    std::uniform_int_distribution<set_type> rand_hash(0, sketch_size - 1);
+    std::uniform_int_distribution<set_type> rand_bool(0, 1);
+
+    for (size_t r = 0; r < hashes->size(); r++) {
+        for (size_t h = 0; h < (*hashes)[r].size(); h++) {
+            for (size_t c = 0; c < alphabet_size; c++) {
+                (*hashes)[r][h][c] = rand_hash(gen);
+                (*signs)[r][h][c] = rand_bool(gen);
+            }
+        }
+    }
+}
+
+/** Each repetition must compute the same sketch as a Tensor with the same hash functions */
+TEST(TensorMulti, SameAsTensorPerRepetition) {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size - 1);
+    std::uniform_int_distribution<uint32_t> rand_len(0, 200);
+    for (uint32_t sketch_dimension : { 1, 3, 16, 33 }) {
+        Vec3D<uint8_t> hashes = new3D<uint8_t>(num_repetitions, tuple_length, alphabet_size);
+        Vec3D<bool> signs = new3D<bool>(num_repetitions, tuple_length, alphabet_size);
+        rand_init(sketch_dimension, &hashes, &signs);
+        TensorMulti<uint8_t> under_test(alphabet_size, sketch_dimension, tuple_length,
+                                        num_repetitions, /*seed=*/31415);
+        under_test.set_hashes_for_testing(hashes, signs);
+
+        for (uint32_t trial = 0; trial < 5; ++trial) {
+            std::vector<uint8_t> sequence(rand_len(gen));
+            std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(gen); });
+            Vec2D<double> sketches = under_test.compute(sequence);
+            ASSERT_EQ(num_repetitions, sketches.size());
+            for (uint32_t r = 0; r < num_repetitions; ++r) {
+                Tensor<uint8_t> tensor(alphabet_size, sketch_dimension, tuple_length, 31415);
+                tensor.set_hashes_for_testing(hashes[r], signs[r]);
+                std::vector<double> sketch = tensor.compute(sequence);
+                ASSERT_EQ(sketch_dimension, sketches[r].size());
+                for (uint32_t i = 0; i < sketch_dimension; ++i) {
+                    ASSERT_NEAR(sketch[i], sketches[r][i], 1e-12)
+                            << "D=" << sketch_dimension << " r=" << r;
+                }
+            }
+        }
+    }
+}
+
+TEST(TensorMulti, Reducers) {
+    Vec2D<double> a = { { 0, 0 }, { 0, 0 }, { 0, 0 } };
+    Vec2D<double> b = { { 1, 0 }, { 3, 0 }, { 0, 2 } };
+    ASSERT_EQ(std::vector<double>({ 1, 9, 4 }), TensorMulti<uint8_t>::dist_per_repetition(a, b));
+
+    using Reducer = TensorMulti<uint8_t>::Reducer;
+    TensorMulti<uint8_t> median(alphabet_size, 2, tuple_length, 3, 31415, Reducer::median);
+    ASSERT_EQ(4, median.dist(a, b));
+    TensorMulti<uint8_t> mean(alphabet_size, 2, tuple_length, 3, 31415, Reducer::mean);
+    ASSERT_NEAR(14. / 3, mean.dist(a, b), 1e-12);
+}
+
+/** Different repetitions use independent hash functions, so their sketches differ */
+TEST(TensorMulti, IndependentRepetitions) {
+    TensorMulti<uint8_t> under_test(alphabet_size, 16, tuple_length, num_repetitions, 31415);
+    Vec2D<double> sketches = under_test.compute({ 0, 1, 2, 3, 0, 1, 2, 3 });
+    for (uint32_t r = 1; r < num_repetitions; ++r) {
+        ASSERT_NE(sketches[0], sketches[r]);
+    }
+}
+
+} // namespace
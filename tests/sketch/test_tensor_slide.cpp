@@ -232,4 +232,81 @@ TEST(TensorSlide, SameAsTensorSketchMultipleWindows) {
     }
 }
 
+/**
+ * The single precision sketch must stay close to the double precision one. The state is kept in
+ * double in both cases, so the only difference is the rounding of the output.
+ */
+TEST(TensorSlide, FloatCloseToDouble) {
+    std::mt19937 gen(3412343);
+    std::uniform_int_distribution<uint8_t> rand_alphabet(0, alphabet_size - 1);
+    std::vector<uint8_t> sequence(1000);
+    std::generate(sequence.begin(), sequence.end(), [&]() { return rand_alphabet(gen); });
+    for (uint32_t sketch_dimension : { 3, 16, 64 }) {
+        for (uint32_t tuple_size : { 1, 3, 6 }) {
+            TensorSlide<uint8_t> tensor_slide(alphabet_size, sketch_dimension, tuple_size, 100,
+                                              50, /*seed=*/31415);
+            TensorSlide<uint8_t, float> tensor_slide_float(alphabet_size, sketch_dimension,
+                                                           tuple_size, 100, 50, /*seed=*/31415);
+            Vec2D<double> slide_sketch = tensor_slide.compute(sequence);
+            Vec2D<float> slide_sketch_float = tensor_slide_float.compute(sequence);
+            ASSERT_EQ(slide_sketch.size(), slide_sketch_float.size());
+            for (uint32_t i = 0; i < slide_sketch.size(); ++i) {
+                for (uint32_t j = 0; j < sketch_dimension; ++j) {
+                    ASSERT_NEAR(slide_sketch[i][j], slide_sketch_float[i][j], 1e-6)
+                            << "D=" << sketch_dimension << " t=" << tuple_size << " window=" << i;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Sketching chunks of the sequence independently, each warmed up on the window preceding it, must
+ * give the same sketches as sliding over the whole sequence
+ */
+TEST(TensorSlide, ParallelSameAsSingle) {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<uint8_t> rand_alphabet(0, alphabet_size - 1);
+    std::uniform_int_distribution<uint32_t> rand_len(0, 1000);
+    for (uint32_t tuple_size : { 1, 3, 6 }) {
+        TensorSlide<uint8_t> tensor_slide(alphabet_size, 16, tuple_size, window_length, stride,
+                                          /*seed=*/31415);
+        for (uint32_t num_chunks : { 1, 2, 3, 7, 50, 2000 }) {
+            std::vector<uint8_t> sequence(rand_len(gen));
+            std::generate(sequence.begin(), sequence.end(), [&]() { return rand_alphabet(gen); });
+            Vec2D<double> slide_sketch = tensor_slide.compute(sequence);
+            Vec2D<double> parallel_sketch = tensor_slide.compute_parallel(sequence, num_chunks);
+            ASSERT_EQ(slide_sketch.size(), parallel_sketch.size());
+            for (uint32_t i = 0; i < slide_sketch.size(); ++i) {
+                for (uint32_t j = 0; j < 16; ++j) {
+                    ASSERT_NEAR(slide_sketch[i][j], parallel_sketch[i][j], 1e-9)
+                            << "t=" << tuple_size << " chunks=" << num_chunks
+                            << " n=" << sequence.size() << " window=" << i;
+                }
+            }
+        }
+    }
+}
+
+/** Streaming the sketches to a sink must produce exactly the sketches returned by compute */
+TEST(TensorSlide, StreamingSameAsCompute) {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<uint8_t> rand_alphabet(0, alphabet_size - 1);
+    TensorSlide<uint8_t> tensor_slide(alphabet_size, 16, tuple_length, window_length, stride,
+                                      /*seed=*/31415);
+    // also covers sequences shorter than the tuple length, for which the sketches are 0
+    for (uint32_t len : { 0, 2, 8, 31, 32, 33, 500 }) {
+        std::vector<uint8_t> sequence(len);
+        std::generate(sequence.begin(), sequence.end(), [&]() { return rand_alphabet(gen); });
+        Vec2D<double> slide_sketch = tensor_slide.compute(sequence);
+        size_t num_sketches = 0;
+        tensor_slide.compute(sequence, [&](size_t index, const std::vector<double> &sketch) {
+            ASSERT_EQ(num_sketches, index);
+            ASSERT_EQ(slide_sketch[index], sketch) << "len=" << len;
+            num_sketches++;
+        });
+        ASSERT_EQ(slide_sketch.size(), num_sketches);
+    }
+}
+
 } // namespace
@@ -0,0 +1,51 @@
+#include "sketch/dim_reduce.hpp"
+#include "sketch/tensor_slide_flat.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace {
+
+using namespace ts;
+using namespace ::testing;
+
+constexpr uint8_t alphabet_size = 4;
+constexpr uint32_t sketch_dim = 8;
+constexpr uint32_t tuple_length = 3;
+constexpr uint32_t window_length = 32;
+constexpr uint32_t stride = 8;
+constexpr uint32_t flat_dim = 20;
+constexpr uint32_t max_len = 500;
+
+/**
+ * Flattening each sliding sketch as soon as it is computed must give the same result as flattening
+ * the stored sketches
+ */
+template <class Flattener>
+void check_same_as_flatten() {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size - 1);
+    Flattener flattener(flat_dim, sketch_dim, max_len, /*seed=*/31415);
+    TensorSlide<uint8_t> tensor_slide(alphabet_size, sketch_dim, tuple_length, window_length,
+                                      stride, /*seed=*/31415);
+    TensorSlideFlat<uint8_t, Flattener> under_test(alphabet_size, sketch_dim, tuple_length,
+                                                   window_length, stride, flattener,
+                                                   /*seed=*/31415);
+    for (uint32_t len : { 8u, 100u, max_len }) {
+        std::vector<uint8_t> sequence(len);
+        std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(gen); });
+        ASSERT_EQ(flattener.flatten(tensor_slide.compute(sequence)), under_test.compute(sequence))
+                << "len=" << len;
+    }
+}
+
+TEST(TensorSlideFlat, Int32SameAsFlatten) {
+    check_same_as_flatten<Int32Flattener>();
+}
+
+TEST(TensorSlideFlat, DoubleSameAsFlatten) {
+    check_same_as_flatten<DoubleFlattener>();
+}
+
+} // namespace
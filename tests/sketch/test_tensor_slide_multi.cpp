@@ -0,0 +1,43 @@
+#include "sketch/tensor_slide.hpp"
+#include "sketch/tensor_slide_multi.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace {
+
+using namespace ts;
+using namespace ::testing;
+
+constexpr uint8_t alphabet_size = 4;
+constexpr uint32_t stride = 8;
+
+/** The sketches of each window length must be the ones computed by a TensorSlide */
+TEST(TensorSlideMulti, SameAsTensorSlidePerWindow) {
+    std::mt19937 gen(31415);
+    std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size - 1);
+    const std::vector<uint32_t> win_lens = { 8, 32, 100 };
+    for (uint32_t sketch_dimension : { 1, 16, 33 }) {
+        for (uint32_t tuple_len : { 1, 3, 6 }) {
+            TensorSlideMulti<uint8_t> under_test(alphabet_size, sketch_dimension, tuple_len,
+                                                 win_lens, stride, /*seed=*/31415);
+            // also covers sequences shorter than the tuple length and than the windows
+            for (uint32_t len : { 0, 2, 50, 500 }) {
+                std::vector<uint8_t> sequence(len);
+                std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(gen); });
+                Vec3D<double> sketches = under_test.compute(sequence);
+                ASSERT_EQ(win_lens.size(), sketches.size());
+                for (uint32_t k = 0; k < win_lens.size(); ++k) {
+                    TensorSlide<uint8_t> tensor_slide(alphabet_size, sketch_dimension, tuple_len,
+                                                      win_lens[k], stride, /*seed=*/31415);
+                    ASSERT_EQ(tensor_slide.compute(sequence), sketches[k])
+                            << "D=" << sketch_dimension << " t=" << tuple_len << " len=" << len
+                            << " w=" << win_lens[k];
+                }
+            }
+        }
+    }
+}
+
+} // namespace
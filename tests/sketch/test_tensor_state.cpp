@@ -0,0 +1,97 @@
+#include "sketch/tensor_state.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <sstream>
+
+namespace {
+
+using namespace ts;
+using namespace ::testing;
+
+constexpr uint8_t alphabet_size = 4;
+constexpr uint32_t sketch_dim = 17;
+constexpr uint32_t tuple_length = 4;
+
+std::vector<uint8_t> rand_sequence(uint32_t len, std::mt19937 *gen) {
+    // include some characters outside the alphabet, which must be skipped
+    std::uniform_int_distribution<uint8_t> rand_char(0, alphabet_size);
+    std::vector<uint8_t> sequence(len);
+    std::generate(sequence.begin(), sequence.end(), [&]() { return rand_char(*gen); });
+    return sequence;
+}
+
+/** Feeding a sequence in arbitrary chunks must give the same sketch as computing it at once */
+TEST(TensorState, SameAsCompute) {
+    std::mt19937 gen(31415);
+    Tensor<uint8_t> sketcher(alphabet_size, sketch_dim, tuple_length, /*seed=*/31415);
+    for (uint32_t trial = 0; trial < 10; ++trial) {
+        const std::vector<uint8_t> sequence = rand_sequence(500, &gen);
+        TensorState<uint8_t> state(sketcher);
+        ASSERT_THAT(state.finalize(), Each(0));
+        std::uniform_int_distribution<size_t> rand_chunk(0, 50);
+        for (size_t pos = 0; pos < sequence.size();) {
+            const size_t n = std::min(rand_chunk(gen), sequence.size() - pos);
+            state.update(sequence.data() + pos, n);
+            pos += n;
+            ASSERT_EQ(pos, state.size());
+            // the sketch of the prefix seen so far is available at any time
+            std::vector<uint8_t> prefix(sequence.begin(), sequence.begin() + pos);
+            ASSERT_THAT(state.finalize(), ElementsAreArray(sketcher.compute(prefix)));
+        }
+    }
+}
+
+/** A state that is saved and loaded again must continue exactly where it was paused */
+TEST(TensorState, SaveLoad) {
+    std::mt19937 gen(31415);
+    Tensor<uint8_t, float> sketcher(alphabet_size, sketch_dim, tuple_length, /*seed=*/31415);
+    const std::vector<uint8_t> sequence = rand_sequence(1000, &gen);
+
+    TensorState<uint8_t, float> state(sketcher);
+    state.update(sequence.data(), 400);
+    std::stringstream saved;
+    state.save(saved);
+
+    TensorState<uint8_t, float> resumed(sketcher);
+    resumed.load(saved);
+    ASSERT_EQ(400, resumed.size());
+    resumed.update(sequence.data() + 400, sequence.size() - 400);
+    ASSERT_THAT(resumed.finalize(), ElementsAreArray(sketcher.compute(sequence)));
+}
+
+TEST(TensorState, LoadRejectsOtherStates) {
+    std::mt19937 gen(31415);
+    Tensor<uint8_t> sketcher(alphabet_size, sketch_dim, tuple_length, /*seed=*/31415);
+    const std::vector<uint8_t> sequence = rand_sequence(100, &gen);
+    TensorState<uint8_t> state(sketcher);
+    state.update(sequence.data(), sequence.size());
+    std::stringstream saved;
+    state.save(saved);
+    const std::string bytes = saved.str();
+
+    // different hash functions
+    Tensor<uint8_t> other_seed(alphabet_size, sketch_dim, tuple_length, /*seed=*/27182);
+    TensorState<uint8_t> other(other_seed);
+    std::stringstream in(bytes);
+    EXPECT_THROW(other.load(in), std::invalid_argument);
+
+    // different dimension
+    Tensor<uint8_t> other_dim(alphabet_size, sketch_dim + 1, tuple_length, /*seed=*/31415);
+    TensorState<uint8_t> other2(other_dim);
+    in.str(bytes);
+    EXPECT_THROW(other2.load(in), std::invalid_argument);
+
+    // truncated state; the state must be left unchanged
+    TensorState<uint8_t> truncated(sketcher);
+    std::stringstream in_truncated(bytes.substr(0, bytes.size() - 1));
+    EXPECT_THROW(truncated.load(in_truncated), std::invalid_argument);
+    EXPECT_EQ(0, truncated.size());
+
+    std::stringstream garbage("not a state");
+    EXPECT_THROW(truncated.load(garbage), std::invalid_argument);
+}
+
+} // namespace
@@ -12,13 +12,13 @@ using namespace ts;
 using namespace ::testing;
 
 TEST(WeightedMinHash, Empty) {
-    WeightedMinHash<uint8_t> under_test(4 * 4 * 4, 3, 100, HashAlgorithm::uniform, /*seed=*/31415);
+    WeightedMinHash<uint8_t, HashAlgorithm::uniform> under_test(4 * 4 * 4, 3, 100, /*seed=*/31415);
     std::vector<uint8_t> sketch = under_test.compute(std::vector<uint8_t>());
     ASSERT_THAT(sketch, ElementsAre(0, 0, 0));
 }
 
 TEST(WeightedMinHash, Repeat) {
-    WeightedMinHash<uint8_t> under_test(4 * 4 * 4, 3, 100, HashAlgorithm::uniform, /*seed=*/31415);
+    WeightedMinHash<uint8_t, HashAlgorithm::uniform> under_test(4 * 4 * 4, 3, 100, /*seed=*/31415);
     std::vector<uint8_t> sequence = { 0, 1, 2, 3, 4, 5 };
     std::vector<uint8_t> sketch1 = under_test.compute(sequence);
     std::vector<uint8_t> sketch2 = under_test.compute(sequence);
@@ -26,7 +26,7 @@ TEST(WeightedMinHash, Repeat) {
 }
 
 TEST(WeightedMinHash, Permute) {
-    WeightedMinHash<uint8_t> under_test(4 * 4 * 4, 3, 100, HashAlgorithm::uniform, /*seed=*/31415);
+    WeightedMinHash<uint8_t, HashAlgorithm::uniform> under_test(4 * 4 * 4, 3, 100, /*seed=*/31415);
     std::vector<uint8_t> sequence1 = { 0, 1, 2, 3, 4, 5 };
     std::vector<uint8_t> sequence2 = { 5, 4, 3, 2, 1, 0 };
     std::vector<uint8_t> sketch1 = under_test.compute(sequence1);
@@ -46,7 +46,7 @@ hash_init(uint32_t set_sz, uint32_t sketch_size, uint32_t max_seq_len) {
 }
 
 TEST(WeightedMinHash, PresetHash) {
-    WeightedMinHash<uint8_t> under_test(4 * 4, 3, 100, HashAlgorithm::uniform, /*seed=*/31415);
+    WeightedMinHash<uint8_t, HashAlgorithm::uniform> under_test(4 * 4, 3, 100, /*seed=*/31415);
     under_test.set_hashes_for_testing(hash_init(4 * 4, 3, 100));
     for (uint32_t i = 0; i < 4 * 4; ++i) {
         std::vector<uint8_t> sequence(4 * 4 - i);
@@ -58,7 +58,7 @@ TEST(WeightedMinHash, PresetHash) {
 
 TEST(WeightedMinHash, PresetHashRepeat) {
     constexpr uint32_t set_size = 4 * 4; // corresponds to k-mers of length 2 over the DNA alphabet
-    WeightedMinHash<uint8_t> under_test(set_size, 3, 100, HashAlgorithm::uniform, /*seed=*/31415);
+    WeightedMinHash<uint8_t, HashAlgorithm::uniform> under_test(set_size, 3, 100, /*seed=*/31415);
     under_test.set_hashes_for_testing(hash_init(set_size, 3, 100));
     for (uint32_t i = 0; i < set_size; ++i) {
         std::vector<uint8_t> sequence(2 * (set_size - i));
@@ -72,7 +72,7 @@ TEST(WeightedMinHash, PresetHashRepeat) {
 #ifndef NDEBUG
 TEST(WeightedMinhash, SequenceTooLong) {
     constexpr uint32_t set_size = 4 * 4; // corresponds to k-mers of length 2 over the DNA alphabet
-    WeightedMinHash<uint8_t> under_test(set_size, 3, 100, HashAlgorithm::uniform, /*seed=*/31415);
+    WeightedMinHash<uint8_t, HashAlgorithm::uniform> under_test(set_size, 3, 100, /*seed=*/31415);
     std::vector<uint8_t> sequence(100 + 1);
     ASSERT_THROW(under_test.compute(sequence), std::invalid_argument);
 }
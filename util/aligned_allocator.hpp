@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace ts { // ts = Tensor Sketch
+
+/**
+ * A minimal allocator that returns memory aligned to #Alignment bytes, so that rows of the sketch
+ * state start on a cache line and can be loaded efficiently with SIMD instructions.
+ */
+template <class T, size_t Alignment = 64>
+class AlignedAllocator {
+  public:
+    using value_type = T;
+
+    template <class U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T *p, size_t) { ::operator delete(p, std::align_val_t(Alignment)); }
+
+    template <class U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const {
+        return true;
+    }
+
+    template <class U>
+    bool operator!=(const AlignedAllocator<U, Alignment> &) const {
+        return false;
+    }
+};
+
+template <class T>
+using AlignedVec = std::vector<T, AlignedAllocator<T>>;
+
+/** Rounds #len up to a whole number of 64 byte cache lines of T elements. */
+template <class T>
+constexpr size_t aligned_len(size_t len) {
+    constexpr size_t per_line = 64 / sizeof(T);
+    return (len + per_line - 1) / per_line * per_line;
+}
+
+} // namespace ts
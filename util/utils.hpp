@@ -46,10 +46,14 @@ std::vector<kmer> seq2kmer(const std::vector<chr> &seq, uint8_t kmer_size, uint8
     return result;
 }
 
-template <class T>
-T l1_dist(const std::vector<T> &a, const std::vector<T> &b) {
+/**
+ * The distance helpers below accumulate in R, which defaults to the element type T. Use R=double
+ * for float sketches, so that summing many small squared differences doesn't lose precision.
+ */
+template <class T, class R = T>
+R l1_dist(const std::vector<T> &a, const std::vector<T> &b) {
     assert(a.size() == b.size());
-    T res = 0;
+    R res = 0;
     for (size_t i = 0; i < a.size(); i++) {
         auto el = std::abs(a[i] - b[i]);
         res += el;
@@ -58,22 +62,22 @@ T l1_dist(const std::vector<T> &a, const std::vector<T> &b) {
 }
 
 
-template <class T>
-T l2_dist(const std::vector<T> &a, const std::vector<T> &b) {
+template <class T, class R = T>
+R l2_dist(const std::vector<T> &a, const std::vector<T> &b) {
     assert(a.size() == b.size());
-    T res = 0;
+    R res = 0;
     for (size_t i = 0; i < a.size(); i++) {
-        auto el = std::abs(a[i] - b[i]);
+        R el = std::abs(a[i] - b[i]);
         res += el * el;
     }
     return res;
 }
 
 
-template <class T>
-T l1_dist2D_minlen(const Vec2D<T> &a, const Vec2D<T> &b) {
+template <class T, class R = T>
+R l1_dist2D_minlen(const Vec2D<T> &a, const Vec2D<T> &b) {
     auto len = std::min(a.size(), b.size());
-    T val = 0;
+    R val = 0;
     for (size_t i = 0; i < len; i++) {
         for (size_t j = 0; j < a[i].size() and j < b[i].size(); j++) {
             auto el = std::abs(a[i][j] - b[i][j]);
@@ -83,13 +87,13 @@ T l1_dist2D_minlen(const Vec2D<T> &a, const Vec2D<T> &b) {
     return val;
 }
 
-template <class T>
-T l2_dist2D_minlen(const Vec2D<T> &a, const Vec2D<T> &b) {
+template <class T, class R = T>
+R l2_dist2D_minlen(const Vec2D<T> &a, const Vec2D<T> &b) {
     auto len = std::min(a.size(), b.size());
-    T val = 0;
+    R val = 0;
     for (size_t i = 0; i < len; i++) {
         for (size_t j = 0; j < a[i].size() and j < b[i].size(); j++) {
-            auto el = (a[i][j] - b[i][j]);
+            R el = (a[i][j] - b[i][j]);
             val += el * el;
         }
     }